@@ -0,0 +1,39 @@
+include(../../mcplayer.pri)
+
+# QBENCHMARK suite of the database layer, on an in-memory and an on-disk SQLite database.
+# "make benchmark" runs it and writes the results to benchmark.xml for comparing runs,
+# other formats by hand: ./tst_bench_database -o results.csv,csv
+QT += testlib sql concurrent
+QT -= gui
+CONFIG += c++11 console testcase
+CONFIG -= app_bundle
+TEMPLATE = app
+TARGET = tst_bench_database
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+BASE_PATH = $$MCPLAYER_SOURCE_TREE/src/base
+DATABASE_PATH = $$BASE_PATH/database
+
+INCLUDEPATH += \
+    $$BASE_PATH \
+    $$DATABASE_PATH \
+    $$DATABASE_PATH/connectors \
+    $$DATABASE_PATH/query \
+    $$DATABASE_PATH/schema \
+    $$DATABASE_PATH/models \
+    $$DATABASE_PATH/models/relations
+
+HEADERS += \
+    $$BASE_PATH/TaskStatistics.h \
+    $$BASE_PATH/RuntimeError.h \
+    $$files($$DATABASE_PATH/*.h, true)
+
+SOURCES += \
+    $$BASE_PATH/TaskStatistics.cpp \
+    $$BASE_PATH/RuntimeError.cpp \
+    $$files($$DATABASE_PATH/*.cpp, true) \
+    tst_bench_database.cpp
+
+benchmark.commands = ./$$TARGET -o benchmark.xml,xml -o -,txt
+QMAKE_EXTRA_TARGETS += benchmark
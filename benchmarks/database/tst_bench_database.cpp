@@ -0,0 +1,334 @@
+#include "Database.h"
+#include "Connection.h"
+#include "query/QueryBuilder.h"
+#include "query/QueryGrammar.h"
+#include "schema/Blueprint.h"
+#include "schema/SQLiteSchemaGrammar.h"
+#include "models/Model.h"
+#include "models/EloquentBuilder.h"
+
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QJsonObject>
+
+static QtMessageHandler g_previousHandler = nullptr;
+
+// debug output of the library is not part of what is measured
+static void quietMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message)
+{
+    if(type != QtDebugMsg && type != QtInfoMsg && g_previousHandler)
+        g_previousHandler(type, context, message);
+}
+
+class Track : public Model
+{
+    Q_OBJECT
+    Q_PROPERTY(int id READ id WRITE setId)
+    Q_PROPERTY(int album_id READ albumId WRITE setAlbumId)
+    Q_PROPERTY(QString title READ title WRITE setTitle)
+    Q_PROPERTY(int duration READ duration WRITE setDuration)
+public:
+    Q_INVOKABLE explicit Track(QObject *parent = nullptr) : Model(parent) {}
+
+    QString table() const override { return "tracks"; }
+
+    int id() const { return m_id; }
+    int albumId() const { return m_albumId; }
+    QString title() const { return m_title; }
+    int duration() const { return m_duration; }
+
+public slots:
+    void setId(int id) { m_id = id; }
+    void setAlbumId(int id) { m_albumId = id; }
+    void setTitle(const QString &title) { m_title = title; }
+    void setDuration(int duration) { m_duration = duration; }
+
+private:
+    int m_id = 0;
+    int m_albumId = 0;
+    QString m_title;
+    int m_duration = 0;
+};
+
+class Album : public Model
+{
+    Q_OBJECT
+    Q_PROPERTY(int id READ id WRITE setId)
+    Q_PROPERTY(QString title READ title WRITE setTitle)
+public:
+    Q_INVOKABLE explicit Album(QObject *parent = nullptr) : Model(parent) {}
+
+    QString table() const override { return "albums"; }
+
+    int id() const { return m_id; }
+    QString title() const { return m_title; }
+
+    Q_INVOKABLE Relation tracks() const
+    {
+        return hasMany<Track>();
+    }
+
+public slots:
+    void setId(int id) { m_id = id; }
+    void setTitle(const QString &title) { m_title = title; }
+
+private:
+    int m_id = 0;
+    QString m_title;
+};
+
+/**
+ * @brief The DatabaseBenchmark class
+ * "memory" and "disk" rows run against an in-memory and an on-disk SQLite
+ * database, no other service is needed.
+ */
+class DatabaseBenchmark : public QObject
+{
+    Q_OBJECT
+
+private:
+    static const int Albums = 50;
+    static const int TracksPerAlbum = 20;
+
+    void addConnections()
+    {
+        QTest::addColumn<QString>("connection");
+        QTest::newRow("memory") << "bench_memory";
+        QTest::newRow("disk") << "bench_disk";
+    }
+
+    // the clauses of the builders from their arena or from the heap
+    void addAllocations()
+    {
+        QTest::addColumn<bool>("arena");
+        QTest::newRow("arena") << true;
+        QTest::newRow("heap") << false;
+    }
+
+    Connection *connection(const QString &name) const
+    {
+        return Database::instance()->connection(name);
+    }
+
+    QList<QVariantMap> trackRows(int count) const
+    {
+        QList<QVariantMap> rows;
+        for(int i = 0; i < count; ++i)
+        {
+            rows << QVariantMap{
+                { "album_id", i / TracksPerAlbum + 1 },
+                { "title", QString("Track %1").arg(i) },
+                { "duration", 180 + i % 120 }
+            };
+        }
+        return rows;
+    }
+
+    void seed(Connection *db)
+    {
+        db->statement("delete from tracks");
+        db->statement("delete from albums");
+
+        QList<QVariantMap> albums;
+        for(int i = 1; i <= Albums; ++i)
+            albums << QVariantMap{ { "id", i }, { "title", QString("Album %1").arg(i) } };
+
+        db->queryBuilder().from("albums").insert(albums);
+        db->queryBuilder().from("tracks").insert(trackRows(Albums * TracksPerAlbum));
+    }
+
+    QTemporaryDir dir;
+
+private slots:
+    void initTestCase()
+    {
+        g_previousHandler = qInstallMessageHandler(quietMessageHandler);
+        QVERIFY(dir.isValid());
+
+        QJsonObject memory{
+            { "driver", "qsqlite" },
+            { "database", ":memory:" },
+            { "prefix", "" },
+            { "profile", "none" }
+        };
+        QJsonObject disk{
+            { "driver", "qsqlite" },
+            { "database", dir.filePath("bench.db") },
+            { "prefix", "" },
+            { "profile", "library" }
+        };
+        Database::instance()->addConnection(memory, "bench_memory");
+        Database::instance()->addConnection(disk, "bench_disk");
+
+        foreach (auto name, QStringList({"bench_memory", "bench_disk"}))
+        {
+            Connection *db = connection(name);
+            QVERIFY(db);
+            db->statement("create table albums (id integer primary key, title text)");
+            db->statement("create table tracks (id integer primary key, album_id integer, "
+                          "title text, duration integer)");
+            db->statement("create index tracks_album_id_index on tracks (album_id)");
+        }
+    }
+
+    void builder_data() { addAllocations(); }
+    void builder()
+    {
+        QFETCH(bool, arena);
+        QueryBuilder::setArenaEnabled(arena);
+        Connection *db = connection("bench_memory");
+        QBENCHMARK
+        {
+            QueryBuilder query = db->queryBuilder();
+            query.from("tracks")
+                    .where("album_id", "=", 3)
+                    .where("duration", ">", 60)
+                    .whereNotNull("title")
+                    .orderBy("title")
+                    .limit(20);
+        }
+
+        QueryBuilder::setArenaEnabled(true);
+    }
+
+    // a long-lived builder paging through a table replaces its limit and offset
+    void builderPaging_data() { addAllocations(); }
+    void builderPaging()
+    {
+        QFETCH(bool, arena);
+        QueryBuilder::setArenaEnabled(arena);
+        Connection *db = connection("bench_memory");
+        QueryBuilder query = db->queryBuilder();
+        query.from("tracks").where("album_id", "=", 3).orderBy("title");
+        int page = 0;
+        QBENCHMARK
+        {
+            query.forPage(++page % 50 + 1, 20);
+        }
+
+        QueryBuilder::setArenaEnabled(true);
+    }
+
+    void compile_data()
+    {
+        QTest::addColumn<bool>("cache");
+        QTest::newRow("cached") << true;
+        QTest::newRow("uncached") << false;
+    }
+
+    void compile()
+    {
+        QFETCH(bool, cache);
+        Connection *db = connection("bench_memory");
+        QueryGrammar *grammar = qobject_cast<QueryGrammar *>(db->queryGrammar().data());
+        QVERIFY(grammar);
+        grammar->setCacheEnabled(cache);
+
+        QueryBuilder query = db->queryBuilder();
+        query.from("tracks").select("id, title")
+                .where("album_id", "=", 3)
+                .where("duration", ">", 60)
+                .orderBy("title")
+                .limit(20);
+
+        QBENCHMARK
+        {
+            grammar->compilePrepared(&query, QueryBuilder::SelectStatement);
+        }
+
+        grammar->setCacheEnabled(true);
+    }
+
+    void blueprint()
+    {
+        SQLiteSchemaGrammar grammar;
+        QBENCHMARK
+        {
+            Blueprint blueprint("tracks", [](Blueprint *table) {
+                table->increments("id");
+                table->integer("album_id");
+                table->string("title");
+                table->integer("duration");
+                table->timestamps();
+                table->index({"album_id"});
+            });
+            blueprint.create();
+            blueprint.toSql(&grammar);
+        }
+    }
+
+    void insertSingle_data() { addConnections(); }
+    void insertSingle()
+    {
+        QFETCH(QString, connection);
+        Connection *db = this->connection(connection);
+        const QList<QVariantMap> rows = trackRows(100);
+
+        QBENCHMARK
+        {
+            db->statement("delete from tracks");
+            foreach (auto &row, rows)
+                db->queryBuilder().from("tracks").insert(row);
+        }
+    }
+
+    void insertBulk_data() { addConnections(); }
+    void insertBulk()
+    {
+        QFETCH(QString, connection);
+        Connection *db = this->connection(connection);
+        const QList<QVariantMap> rows = trackRows(100);
+
+        QBENCHMARK
+        {
+            db->statement("delete from tracks");
+            db->queryBuilder().from("tracks").insert(rows);
+        }
+    }
+
+    void hydrate_data() { addConnections(); }
+    void hydrate()
+    {
+        QFETCH(QString, connection);
+        Connection *db = this->connection(connection);
+        seed(db);
+
+        Track prototype;
+        prototype.setConnection(db);
+
+        QBENCHMARK
+        {
+            Collection tracks = prototype.newQuery().get();
+            QCOMPARE(tracks.size(), Albums * TracksPerAlbum);
+            qDeleteAll(tracks);
+        }
+    }
+
+    void relations_data() { addConnections(); }
+    void relations()
+    {
+        QFETCH(QString, connection);
+        Connection *db = this->connection(connection);
+        seed(db);
+
+        Album prototype;
+        prototype.setConnection(db);
+
+        QBENCHMARK
+        {
+            Collection albums = prototype.with({"tracks"}).get();
+            QCOMPARE(albums.size(), Albums);
+            qDeleteAll(albums);
+        }
+    }
+
+    void cleanupTestCase()
+    {
+        delete Database::instance();
+        qInstallMessageHandler(g_previousHandler);
+    }
+};
+
+QTEST_GUILESS_MAIN(DatabaseBenchmark)
+
+#include "tst_bench_database.moc"
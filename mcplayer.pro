@@ -1,4 +1,7 @@
 TEMPLATE = subdirs
 
 SUBDIRS += \
-	src
\ No newline at end of file
+	src
+
+# the database benchmarks, qmake CONFIG+=benchmarks
+benchmarks: SUBDIRS += benchmarks
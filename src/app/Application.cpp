@@ -1,5 +1,8 @@
 #include "Application.h"
 #include "player/MediaPlayer.h"
+#include "IdleTaskScheduler.h"
+#include "DatabaseOptimizeTask.h"
+#include "TaskStatistics.h"
 #include "utils/Lazy.h"
 
 #ifndef DISABLE_GUI
@@ -24,11 +27,22 @@ public:
 
     QTranslator translator;
     Util::Lazy<MediaPlayer> miniPlayer;
+    Util::Lazy<IdleTaskScheduler> maintenance;
 };
 
 ApplicationPrivate::ApplicationPrivate(Application *app)
     : q_ptr(app)
     , miniPlayer([=]{ return new MediaPlayer(app); })
+    , maintenance([=]{
+        // library maintenance only runs while the player is not playing
+        IdleTaskScheduler *scheduler = new IdleTaskScheduler(app);
+        scheduler->watch(miniPlayer.get());
+        // refresh the planner statistics of the library once it is idle, then now and then
+        scheduler->schedule([]() {
+            return QSharedPointer<IdleTask>(new DatabaseOptimizeTask());
+        }, 6 * 60 * 60 * 1000);
+        return scheduler;
+    })
 {
 
 }
@@ -48,6 +62,8 @@ Application::Application(int &argc, char **argv)
 
     // enable logger
 	// ...
+    // scheduler statistics, filter with "mcplayer.TaskStatistics.info=false"
+    TaskStatistics::instance()->setLogInterval(60 * 1000);
 
     // 2.install translations
 
@@ -82,6 +98,11 @@ MediaPlayer *Application::player() const
     return d->miniPlayer.get();
 }
 
+IdleTaskScheduler *Application::maintenance() const
+{
+    return d->maintenance.get();
+}
+
 int Application::exec(const QStringList &params)
 {
     Q_UNUSED(params)
@@ -91,5 +112,8 @@ int Application::exec(const QStringList &params)
     d->qmlWindow->show();
 #endif
 
+    // the maintenance lane waits for the player to stop or pause
+    d->maintenance.get();
+
     return BaseApplication::exec();
 }
@@ -14,6 +14,7 @@ using BaseApplication = QCoreApplication;
 #define app() (Application::instance())
 
 class MediaPlayer;
+class IdleTaskScheduler;
 
 class ApplicationPrivate;
 class Application : public BaseApplication
@@ -26,6 +27,7 @@ public:
     ~Application();
 
     MediaPlayer *player() const;
+    IdleTaskScheduler *maintenance() const;
 
     int exec(const QStringList &params = {});
 
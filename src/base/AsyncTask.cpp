@@ -1,12 +1,17 @@
 #include "AsyncTask.h"
+#include "TaskStatistics.h"
 
 #include <QThreadPool>
 #include <QElapsedTimer>
 #include <QAtomicInt>
 #include <QWaitCondition>
 #include <QMutex>
+#include <QTimer>
 #include <QDebug>
 
+// interval of the watchdog checking the running tasks against their deadline
+static const int WatchdogInterval = 200;
+
 class AsyncTaskPrivate
 {
 public:
@@ -20,16 +25,21 @@ public:
     };
 
     AsyncTaskPrivate(AsyncTask *q_ptr) : q(q_ptr) {}
-    void prepare()
+    void prepare(const QString &laneName)
     {
-        elapsTimer.start();
+        lane = laneName;
+        queueTimer.start();
+        TaskStatistics::instance()->taskEnqueued(lane);
     }
 
     QAtomicInt state = IdleState;
 
     QMutex mutex;
     QWaitCondition waitCondition;
+    QElapsedTimer queueTimer;
     QElapsedTimer elapsTimer;
+    QDeadlineTimer deadline = QDeadlineTimer(QDeadlineTimer::Forever);
+    QString lane;
     AsyncTask *q = nullptr;
 };
 
@@ -52,17 +62,37 @@ void AsyncTask::run()
 
     if (isCanceled())
     {
+        if(!d->lane.isEmpty())
+            TaskStatistics::instance()->taskDropped(d->lane);
         // report finished
         return;
     }
 
+    if (isExpired())
+    {
+        qDebug() << this->name() << "expired before started, dropped.";
+        d->state.storeRelease(AsyncTaskPrivate::Canceled);
+        if(!d->lane.isEmpty())
+            TaskStatistics::instance()->taskDropped(d->lane);
+        emit canceled();
+        return;
+    }
+
+    if(!d->lane.isEmpty())
+        TaskStatistics::instance()->taskStarted(d->lane, name(), d->queueTimer.nsecsElapsed() / 1000);
+
+    d->elapsTimer.start();
     d->state.testAndSetRelaxed(AsyncTaskPrivate::IdleState, AsyncTaskPrivate::Running);
     emit started();
 
     // do task as long time
     process();
 
-    if(d->state.load() & AsyncTaskPrivate::Canceled)
+    bool interrupted = d->state.load() & AsyncTaskPrivate::Canceled;
+    if(!d->lane.isEmpty())
+        TaskStatistics::instance()->taskFinished(d->lane, name(), d->elapsTimer.nsecsElapsed() / 1000, interrupted);
+
+    if(interrupted)
     {
         emit canceled();
     }
@@ -73,6 +103,11 @@ void AsyncTask::run()
     }
 }
 
+void AsyncTask::enqueue(const QString &lane)
+{
+    d->prepare(lane);
+}
+
 void AsyncTask::interrupt()
 {
     if (d->state.load() & AsyncTaskPrivate::Canceled)
@@ -121,6 +156,21 @@ qint64 AsyncTask::elapsed() const
     return d->elapsTimer.isValid() ? d->elapsTimer.elapsed() : 0;
 }
 
+QDeadlineTimer AsyncTask::deadline() const
+{
+    return d->deadline;
+}
+
+void AsyncTask::setDeadline(QDeadlineTimer deadline)
+{
+    d->deadline = deadline;
+}
+
+bool AsyncTask::isExpired() const
+{
+    return d->deadline.hasExpired();
+}
+
 QString AsyncTask::name() const
 {
     return QString("AsyncTask");
@@ -134,7 +184,33 @@ TaskId AsyncTask::id() const
 class AsyncTaskSchedulerPrivate
 {
 public:
+    AsyncTaskSchedulerPrivate(AsyncTaskScheduler *q) : q_ptr(q) {}
+
+    void watch()
+    {
+        bool hasDeadline = false;
+        foreach (auto task, tasks)
+        {
+            if(task->deadline().isForever())
+                continue;
+
+            hasDeadline = true;
+            if(task->isRunning() && task->isExpired())
+            {
+                qDebug() << task->name() << "overran its deadline by"
+                         << -task->deadline().remainingTime() << "ms, interrupt.";
+                task->interrupt();
+                emit q_ptr->taskExpired(task->id());
+            }
+        }
+
+        if(!hasDeadline)
+            watchdog->stop();
+    }
+
+    AsyncTaskScheduler *q_ptr = nullptr;
     QThreadPool *threadPool = nullptr;
+    QTimer *watchdog = nullptr;
     QList<AsyncTask::Pointer> tasks;
 };
 
@@ -144,9 +220,12 @@ static AsyncTaskScheduler *taskScheduler = nullptr;
  * @param parent
  */
 AsyncTaskScheduler::AsyncTaskScheduler(QObject *parent)
-    : QObject(parent), d(new AsyncTaskSchedulerPrivate)
+    : QObject(parent), d(new AsyncTaskSchedulerPrivate(this))
 {
     d->threadPool = new QThreadPool(this);
+    d->watchdog = new QTimer(this);
+    d->watchdog->setInterval(WatchdogInterval);
+    connect(d->watchdog, &QTimer::timeout, this, [this]() { d->watch(); });
     qDebug() << "AsyncTaskScheduler::AsyncTaskScheduler()";
 
     taskScheduler = this;
@@ -167,7 +246,7 @@ AsyncTaskScheduler *AsyncTaskScheduler::instance()
 void AsyncTaskScheduler::start(AsyncTask::Pointer task, AsyncTaskScheduler::Priority priority)
 {
     d->tasks.append(task);
-    task->d->prepare();
+    task->enqueue(QStringLiteral("async"));
 
     QWeakPointer<AsyncTask> weakPtr = task;
     connect(task.data(), &AsyncTask::finished, this, [this, weakPtr]()
@@ -181,10 +260,19 @@ void AsyncTaskScheduler::start(AsyncTask::Pointer task, AsyncTaskScheduler::Prio
         emit tasksChanged();
     });
 
+    if(!task->deadline().isForever() && !d->watchdog->isActive())
+        d->watchdog->start();
+
     d->threadPool->start(task.data(), priority);
     emit tasksChanged();
 }
 
+void AsyncTaskScheduler::start(AsyncTask::Pointer task, QDeadlineTimer deadline, AsyncTaskScheduler::Priority priority)
+{
+    task->setDeadline(deadline);
+    this->start(task, priority);
+}
+
 void AsyncTaskScheduler::stop(AsyncTask::Pointer task)
 {
     if(task)
@@ -5,6 +5,7 @@
 #include <QThread>
 #include <QRunnable>
 #include <QSharedPointer>
+#include <QDeadlineTimer>
 
 /*!
  * ConcurrentTask / AsyncTask
@@ -19,6 +20,7 @@ class AsyncTask : public QObject, public QRunnable
 {
     Q_OBJECT
     friend class AsyncTaskScheduler;
+    friend class IdleTaskScheduler;
 public:
     using Pointer = QSharedPointer<AsyncTask>;
 
@@ -30,9 +32,18 @@ public:
     bool wait(quint32 timeout = 0);
 
     /*!
-     * eturns the number of milliseconds since this run was last started.
+     * returns the number of milliseconds since this run was last started.
      */
     qint64 elapsed() const;
+
+    /*!
+     * a task not started before its deadline is dropped by the scheduler,
+     * a running task that overruns it is interrupted. Forever by default.
+     */
+    QDeadlineTimer deadline() const;
+    void setDeadline(QDeadlineTimer deadline);
+    bool isExpired() const;
+
     virtual QString name() const;
     TaskId id() const;
 
@@ -49,6 +60,9 @@ protected:
     void run() override final;
 
 private:
+    // called by the schedulers, starts the queue wait timer of the lane
+    void enqueue(const QString &lane);
+
     QScopedPointer<AsyncTaskPrivate> d;
 };
 
@@ -77,6 +91,7 @@ public:
     static AsyncTaskScheduler *instance();
 
     void start(AsyncTask::Pointer task, AsyncTaskScheduler::Priority priority = AsyncTaskScheduler::InheritPriority);
+    void start(AsyncTask::Pointer task, QDeadlineTimer deadline, AsyncTaskScheduler::Priority priority = AsyncTaskScheduler::InheritPriority);
     void stop(AsyncTask::Pointer task);
     void stop(TaskId id);
     bool hasActiveTask() const;
@@ -85,6 +100,7 @@ public:
 signals:
     void tasksChanged();
     void taskCaneled();
+    void taskExpired(TaskId id);
 
 private:
     QScopedPointer<AsyncTaskSchedulerPrivate> d;
@@ -0,0 +1,106 @@
+#include "DatabaseOptimizeTask.h"
+#include "database/Database.h"
+#include "database/ConnectionProvider.h"
+#include "database/DatabaseWriter.h"
+#include "database/Connection.h"
+#include "database/MemoryDatabase.h"
+
+#include <QFile>
+#include <QJsonObject>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(lcDatabaseOptimizeTask, "mcplayer.DatabaseOptimizeTask")
+
+const static QString DriverKey      = "driver";
+const static QString DatabaseKey    = "database";
+const static QString MemoryKey      = "memory";
+const static QString MemorySyncKey  = "memory_sync";
+const static QString SingleWriterKey = "single_writer";
+
+DatabaseOptimizeTask::DatabaseOptimizeTask(const QString &connection)
+    : IdleTask(), m_connection(connection)
+{
+
+}
+
+QString DatabaseOptimizeTask::name() const
+{
+    return QString("DatabaseOptimizeTask");
+}
+
+void DatabaseOptimizeTask::process()
+{
+    ConnectionProvider *provider = Database::instance()->provider();
+    const QString name = m_connection.isEmpty() ? provider->defaultConnection() : m_connection;
+    const QJsonObject config = provider->configuration(name);
+    const QString file = config.value(DatabaseKey).toString();
+    // "sqlite" or "qsqlite"
+    if(!config.value(DriverKey).toString().endsWith("sqlite", Qt::CaseInsensitive))
+        return;
+    if(file.isEmpty() || !QFile::exists(file))
+        return;
+
+    // the statistics of the memory database, the one the queries run on
+    QString database = file;
+    MemoryDatabase *memory = nullptr;
+    if(config.value(MemoryKey).toBool())
+    {
+        memory = MemoryDatabase::open(file, config.value(MemorySyncKey).toInt(MemoryDatabase::DefaultInterval));
+        if(memory)
+            database = memory->uri();
+    }
+
+    const QString connection = QString("DatabaseOptimizeTask:%1").arg(quintptr(this));
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connection);
+        db.setDatabaseName(database);
+        if(memory)
+            db.setConnectOptions("QSQLITE_OPEN_URI");
+        if(db.open())
+        {
+            QSqlQuery query(db);
+            query.exec("PRAGMA busy_timeout = 5000");
+
+            QStringList tables;
+            query.exec("select name from sqlite_master where type = 'table' and name not like 'sqlite_%'");
+            while(query.next())
+                tables << query.value(0).toString();
+
+            // the statistics are written by the writer when it is the only one allowed to
+            DatabaseWriter *writer = config.value(SingleWriterKey).toBool() ? Database::instance()->writer(name) : nullptr;
+            auto exec = [&query, writer](const QString &sql) -> bool {
+                if(!writer)
+                    return query.exec(sql);
+                return writer->run([sql](Connection *connection) -> bool {
+                    return connection->statement(sql) >= 0;
+                });
+            };
+
+            // the lane may pause between two tables
+            for(const auto &table : tables)
+            {
+                if(!yield())
+                    break;
+
+                QString quoted = table;
+                if(!exec("ANALYZE \"" + quoted.replace("\"", "\"\"") + "\""))
+                    qCWarning(lcDatabaseOptimizeTask) << "ANALYZE" << table << "failed";
+            }
+
+            if(yield())
+                exec("PRAGMA optimize");
+
+            qCDebug(lcDatabaseOptimizeTask) << "analyzed" << tables.size() << "tables of" << database;
+        }
+        else
+        {
+            qCWarning(lcDatabaseOptimizeTask) << "Can not open" << database << db.lastError().text();
+        }
+        db.close();
+    }
+
+    QSqlDatabase::removeDatabase(connection);
+}
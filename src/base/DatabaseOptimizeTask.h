@@ -0,0 +1,31 @@
+#ifndef DATABASEOPTIMIZETASK_H
+#define DATABASEOPTIMIZETASK_H
+
+#include "IdleTaskScheduler.h"
+
+/*!
+ * DatabaseOptimizeTask
+ *
+ * refreshes the query planner statistics of an SQLite database: ANALYZE
+ * one table at a time on a connection of its own, yielding to the idle
+ * lane in between, then PRAGMA optimize. The database is the file of a
+ * configuration of Database, the default one if none is named, or its
+ * memory database when the configuration keeps it in memory: the queries
+ * run there. A missing file or another driver is left alone.
+ */
+class DatabaseOptimizeTask : public IdleTask
+{
+    Q_OBJECT
+public:
+    explicit DatabaseOptimizeTask(const QString &connection = QString());
+
+    QString name() const override;
+
+protected:
+    void process() override;
+
+private:
+    QString m_connection;
+};
+
+#endif // DATABASEOPTIMIZETASK_H
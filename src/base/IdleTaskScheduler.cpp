@@ -0,0 +1,373 @@
+#include "IdleTaskScheduler.h"
+#include "TaskStatistics.h"
+
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <QMutex>
+#include <QQueue>
+#include <QTimer>
+#include <QFile>
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(lcIdleTaskScheduler, "mcplayer.IdleTaskScheduler")
+
+static const int DefaultLoadInterval = 5000;
+static const QString IdleLane = QStringLiteral("idle");
+
+/**
+ * @brief The IdleTaskGate class blocks the idle tasks while the lane is paused
+ */
+class IdleTaskGate
+{
+public:
+    bool wait(const AsyncTask *task)
+    {
+        QMutexLocker lock(&mutex);
+        while(paused && !task->isCanceled())
+            condition.wait(&mutex);
+
+        return !task->isCanceled();
+    }
+
+    bool setPaused(bool value)
+    {
+        QMutexLocker lock(&mutex);
+        if(paused == value)
+            return false;
+
+        paused = value;
+        if(!paused)
+            condition.wakeAll();
+
+        return true;
+    }
+
+    // the lane pauses right away when playing starts, from any thread
+    void setPlaying(bool value)
+    {
+        QMutexLocker lock(&mutex);
+        playing = value;
+        if(playing)
+            paused = true;
+    }
+
+    /**
+     * pause the lane while playing unless the load allows the tasks. The
+     * playback state is read under the lock it is set with, so a late update
+     * can not resume the lane a setPlaying(true) has just paused.
+     */
+    bool update(bool loadAllowed)
+    {
+        QMutexLocker lock(&mutex);
+        bool value = playing && !loadAllowed;
+        if(paused && !value)
+            condition.wakeAll();
+
+        paused = value;
+        return paused;
+    }
+
+    bool isPaused()
+    {
+        QMutexLocker lock(&mutex);
+        return paused;
+    }
+
+    void wakeAll()
+    {
+        QMutexLocker lock(&mutex);
+        condition.wakeAll();
+    }
+
+    QMutex mutex;
+    QWaitCondition condition;
+    bool paused = false;
+    bool playing = false;
+};
+
+/**
+ * @brief IdleTask::IdleTask
+ */
+IdleTask::IdleTask()
+    : AsyncTask()
+{
+
+}
+
+IdleTask::~IdleTask()
+{
+
+}
+
+QString IdleTask::name() const
+{
+    return QString("IdleTask");
+}
+
+void IdleTask::interrupt()
+{
+    AsyncTask::interrupt();
+
+    // wake up the task if it is waiting on the paused lane
+    if(m_gate)
+        m_gate->wakeAll();
+}
+
+bool IdleTask::yield()
+{
+    if(isCanceled())
+        return false;
+
+    return m_gate ? m_gate->wait(this) : true;
+}
+
+class IdleTaskSchedulerPrivate
+{
+public:
+    IdleTaskSchedulerPrivate(IdleTaskScheduler *q) : q_ptr(q) {}
+
+    // the system load is low enough to run beside the playback
+    bool loadAllowed() const
+    {
+        return loadThreshold > 0 && load >= 0 && load < loadThreshold;
+    }
+
+    void update()
+    {
+        bool pause = gate->update(loadAllowed());
+
+        if(pause != paused)
+        {
+            paused = pause;
+            qInfo(lcIdleTaskScheduler) << (paused ? "paused" : "resumed") << "load:" << load;
+            emit q_ptr->pausedChanged(paused);
+        }
+
+        dispatch();
+    }
+
+    void dispatch()
+    {
+        if(running || pending.isEmpty() || gate->isPaused())
+            return;
+
+        running = pending.dequeue();
+
+        IdleTask *task = running.data();
+        auto done = [this, task]()
+        {
+            if(running.data() == task)
+                running.reset();
+
+            emit q_ptr->tasksChanged();
+            dispatch();
+        };
+        QObject::connect(running.data(), &AsyncTask::finished, q_ptr, done);
+        QObject::connect(running.data(), &AsyncTask::canceled, q_ptr, done);
+
+        // interrupt the task if it overruns its deadline
+        if(!task->deadline().isForever())
+        {
+            QTimer::singleShot(qMax<qint64>(0, task->deadline().remainingTime()), q_ptr, [this, task]()
+            {
+                if(running.data() == task && task->isRunning())
+                    task->interrupt();
+            });
+        }
+
+        threadPool->start(running.data());
+        emit q_ptr->tasksChanged();
+    }
+
+    void sampleLoad()
+    {
+        load = IdleTaskScheduler::systemLoad();
+        update();
+    }
+
+    IdleTaskScheduler *q_ptr = nullptr;
+    QThreadPool *threadPool = nullptr;
+    QTimer *loadTimer = nullptr;
+    QSharedPointer<IdleTaskGate> gate;
+    QQueue<QSharedPointer<IdleTask> > pending;
+    QSharedPointer<IdleTask> running;
+
+    bool paused = false;
+    qreal loadThreshold = 0;
+    qreal load = -1;
+};
+
+/**
+ * @brief IdleTaskScheduler::IdleTaskScheduler
+ * @param parent
+ */
+IdleTaskScheduler::IdleTaskScheduler(QObject *parent)
+    : QObject(parent), d(new IdleTaskSchedulerPrivate(this))
+{
+    d->gate.reset(new IdleTaskGate);
+
+    // maintenance work runs one task at a time
+    d->threadPool = new QThreadPool(this);
+    d->threadPool->setMaxThreadCount(1);
+
+    d->loadTimer = new QTimer(this);
+    d->loadTimer->setInterval(DefaultLoadInterval);
+    connect(d->loadTimer, &QTimer::timeout, this, [this]() { d->sampleLoad(); });
+}
+
+IdleTaskScheduler::~IdleTaskScheduler()
+{
+    clear();
+
+    // let the running task leave the paused lane and finish
+    d->gate->setPaused(false);
+    d->threadPool->waitForDone();
+}
+
+void IdleTaskScheduler::watch(MediaPlayer *player)
+{
+    if(!player)
+        return;
+
+    // direct connection: pause the lane in the thread that reports the state
+    connect(player, &MediaPlayer::playbackStateChanged,
+            this, &IdleTaskScheduler::setPlaybackState, Qt::DirectConnection);
+
+    setPlaybackState(player->playbackState());
+}
+
+void IdleTaskScheduler::start(QSharedPointer<IdleTask> task)
+{
+    if(!task)
+        return;
+
+    task->m_gate = d->gate;
+    task->enqueue(IdleLane);
+    d->pending.enqueue(task);
+    emit tasksChanged();
+
+    d->dispatch();
+}
+
+void IdleTaskScheduler::stop(TaskId id)
+{
+    for(auto task : d->pending)
+    {
+        if(task->id() == id)
+        {
+            d->pending.removeOne(task);
+            TaskStatistics::instance()->taskDropped(IdleLane);
+            emit tasksChanged();
+            return;
+        }
+    }
+
+    if(d->running && d->running->id() == id)
+        d->running->interrupt();
+}
+
+void IdleTaskScheduler::clear()
+{
+    for(int i = 0; i < d->pending.count(); ++i)
+        TaskStatistics::instance()->taskDropped(IdleLane);
+
+    d->pending.clear();
+    if(d->running)
+        d->running->interrupt();
+
+    emit tasksChanged();
+}
+
+void IdleTaskScheduler::schedule(Factory factory, int interval, int delay)
+{
+    QTimer *timer = new QTimer(this);
+    timer->setInterval(qMax(0, delay));
+
+    QWeakPointer<IdleTask> last;
+    connect(timer, &QTimer::timeout, this, [this, timer, factory, interval, last]() mutable
+    {
+        timer->setInterval(interval);
+
+        // the previous run is still queued or running
+        if(!last.isNull())
+            return;
+
+        QSharedPointer<IdleTask> task = factory();
+        last = task;
+        start(task);
+    });
+    timer->start();
+}
+
+qreal IdleTaskScheduler::loadThreshold() const
+{
+    return d->loadThreshold;
+}
+
+void IdleTaskScheduler::setLoadThreshold(qreal threshold)
+{
+    d->loadThreshold = threshold;
+    if(threshold > 0)
+    {
+        d->loadTimer->start();
+        d->sampleLoad();
+    }
+    else
+    {
+        d->loadTimer->stop();
+        d->load = -1;
+        d->update();
+    }
+}
+
+int IdleTaskScheduler::loadInterval() const
+{
+    return d->loadTimer->interval();
+}
+
+void IdleTaskScheduler::setLoadInterval(int msec)
+{
+    d->loadTimer->setInterval(qMax(100, msec));
+}
+
+bool IdleTaskScheduler::isPaused() const
+{
+    return d->gate->isPaused();
+}
+
+int IdleTaskScheduler::pendingTaskCount() const
+{
+    return d->pending.count();
+}
+
+bool IdleTaskScheduler::hasActiveTask() const
+{
+    return d->running || !d->pending.isEmpty();
+}
+
+qreal IdleTaskScheduler::systemLoad()
+{
+#if defined(Q_OS_LINUX)
+    QFile file("/proc/loadavg");
+    if(!file.open(QIODevice::ReadOnly))
+        return -1;
+
+    // "0.42 0.35 0.30 1/123 4567", the first field is the 1 minute load average
+    bool ok = false;
+    qreal load = file.readLine().split(' ').value(0).toDouble(&ok);
+    if(!ok)
+        return -1;
+
+    return load / qMax(1, QThread::idealThreadCount());
+#else
+    return -1;
+#endif
+}
+
+void IdleTaskScheduler::setPlaybackState(MediaPlayer::PlaybackState state)
+{
+    // pause the running task right now, it may be called from another thread
+    d->gate->setPlaying(state == MediaPlayer::PlayingState);
+
+    QMetaObject::invokeMethod(this, [this]() { d->update(); }, Qt::QueuedConnection);
+}
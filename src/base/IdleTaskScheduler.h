@@ -0,0 +1,95 @@
+#ifndef IDLETASKSCHEDULER_H
+#define IDLETASKSCHEDULER_H
+
+#include "AsyncTask.h"
+#include "player/MediaPlayer.h"
+
+#include <functional>
+
+/*!
+ * IdleTask / IdleTaskScheduler
+ *
+ * A background lane for library maintenance (ANALYZE, thumbnails,
+ * loudness analysis, duplicate hashing ...). Tasks only run while the
+ * player is stopped or paused, or while the system load is below the
+ * configured threshold. Long running tasks must call yield() between
+ * units of work so the lane can suspend them as soon as playback starts.
+ */
+
+class IdleTaskGate;
+class IdleTask : public AsyncTask
+{
+    Q_OBJECT
+    friend class IdleTaskScheduler;
+public:
+    explicit IdleTask();
+    ~IdleTask() override;
+
+    QString name() const override;
+
+public slots:
+    void interrupt() override;
+
+protected:
+    /*!
+     * blocks while the idle lane is paused.
+     * returns false if the task was interrupted and should return from process().
+     */
+    bool yield();
+
+private:
+    QSharedPointer<IdleTaskGate> m_gate;
+};
+
+class IdleTaskSchedulerPrivate;
+class IdleTaskScheduler : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(IdleTaskScheduler)
+public:
+    using Factory = std::function<QSharedPointer<IdleTask>()>;
+
+    explicit IdleTaskScheduler(QObject *parent = nullptr);
+    ~IdleTaskScheduler();
+
+    // pause the lane when the player reports PlayingState, resume afterwards
+    void watch(MediaPlayer *player);
+
+    void start(QSharedPointer<IdleTask> task);
+    void stop(TaskId id);
+    void clear();
+
+    /**
+     * start a task of factory delay milliseconds from now, then every interval
+     * milliseconds, unless the last one is not done. Like any task it only
+     * runs while the lane is open.
+     */
+    void schedule(Factory factory, int interval, int delay = 0);
+
+    // normalized load (load average / cpu count), <= 0 disables the load check
+    qreal loadThreshold() const;
+    void setLoadThreshold(qreal threshold);
+
+    // interval in milliseconds between two system load samples
+    int loadInterval() const;
+    void setLoadInterval(int msec);
+
+    bool isPaused() const;
+    int pendingTaskCount() const;
+    bool hasActiveTask() const;
+
+    // normalized system load, a negative value if the platform does not provide it
+    static qreal systemLoad();
+
+signals:
+    void pausedChanged(bool paused);
+    void tasksChanged();
+
+public slots:
+    void setPlaybackState(MediaPlayer::PlaybackState state);
+
+private:
+    QScopedPointer<IdleTaskSchedulerPrivate> d;
+};
+
+#endif // IDLETASKSCHEDULER_H
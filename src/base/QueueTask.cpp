@@ -1,5 +1,6 @@
 #include "QueueTask.h"
 #include "QueueTask_p.h"
+#include "TaskStatistics.h"
 
 #include <QCoreApplication>
 #include <QMutexLocker>
@@ -46,6 +47,18 @@ void QueueTaskSchedulerPrivate::wakeThread()
         exitTimer->stop();
 }
 
+void QueueTaskSchedulerPrivate::enqueued(const QueueTask::Pointer &task)
+{
+    task->d_ptr->queueTimer.start();
+    TaskStatistics::instance()->taskEnqueued(lane);
+}
+
+void QueueTaskSchedulerPrivate::dropped(int count)
+{
+    for(int i = 0; i < count; ++i)
+        TaskStatistics::instance()->taskDropped(lane);
+}
+
 void QueueTaskSchedulerPrivate::updateTask()
 {
     Q_Q(QueueTaskScheduler);
@@ -106,6 +119,7 @@ TaskId QueueTaskScheduler::append(QueueTask::Pointer task)
     Q_D(QueueTaskScheduler);
     {
         QMutexLocker lock(&d->penddingMutex);
+        d->enqueued(task);
         d->penddingTasks.append(task);
     }
 
@@ -121,6 +135,8 @@ void QueueTaskScheduler::append(const QueueTaskList &tasks)
     Q_D(QueueTaskScheduler);
     {
         QMutexLocker lock(&d->penddingMutex);
+        for(auto &task : tasks)
+            d->enqueued(task);
         d->penddingTasks.append(tasks);
     }
 
@@ -140,6 +156,7 @@ void QueueTaskScheduler::cancel(TaskId id)
             if(task->id() == id)
             {
                 d->penddingTasks.removeOne(task);
+                d->dropped();
                 return;
             }
         }
@@ -170,10 +187,24 @@ void QueueTaskScheduler::stop()
         d->taskThread = nullptr;
     }
 
+    d->dropped(d->penddingTasks.count());
     d->penddingTasks.clear();
     d->completedTasks.clear();
 }
 
+QString QueueTaskScheduler::lane() const
+{
+    Q_D(const QueueTaskScheduler);
+    return d->lane;
+}
+
+void QueueTaskScheduler::setLane(const QString &lane)
+{
+    Q_D(QueueTaskScheduler);
+    QMutexLocker lock(&d->penddingMutex);
+    d->lane = lane;
+}
+
 
 /**
  * @brief TaskQueueWorker::TaskQueueWorker
@@ -211,9 +242,23 @@ void QueueTaskWorker::processTask()
 
         if(task)
         {
+            QString lane;
+            {
+                QMutexLocker lock(&d->scheduler_p->penddingMutex);
+                lane = d->scheduler_p->lane;
+            }
+
+            TaskStatistics *statistics = TaskStatistics::instance();
+            statistics->taskStarted(lane, task->name(), task->d_ptr->queueTimer.nsecsElapsed() / 1000);
+
+            QElapsedTimer runTimer;
+            runTimer.start();
+
             // take a long time to process task
             task->process();
 
+            statistics->taskFinished(lane, task->name(), runTimer.nsecsElapsed() / 1000);
+
             bool processDone = false;
             {
                 QMutexLocker penddingLock(&d->scheduler_p->penddingMutex);
@@ -15,6 +15,8 @@ class QueueTaskPrivate;
 class QueueTask
 {
     Q_DECLARE_PRIVATE(QueueTask)
+    friend class QueueTaskScheduler;
+    friend class QueueTaskWorker;
 public:
     using Pointer = QSharedPointer<QueueTask>;
 
@@ -49,6 +51,10 @@ public:
     void append(const QueueTaskList &tasks);
     void cancel(TaskId id);
 
+    // name of the lane reported to TaskStatistics, "queue" by default
+    QString lane() const;
+    void setLane(const QString &lane);
+
 signals:
     void taskAdded();
     void processed(QueueTask::Pointer task);
@@ -5,6 +5,7 @@
 #include <QThread>
 #include <QMutex>
 #include <QTimer>
+#include <QElapsedTimer>
 
 class QueueTaskWorker;
 class QueueTaskPrivate
@@ -13,6 +14,7 @@ class QueueTaskPrivate
 public:
     QueueTaskPrivate(QueueTask *q) : q_ptr(q) {}
     QString name;
+    QElapsedTimer queueTimer;
 
 protected:
     QueueTask *q_ptr;
@@ -27,7 +29,10 @@ public:
     QueueTaskSchedulerPrivate(QueueTaskScheduler *q) : q_ptr(q) {}
 
     void wakeThread();
+    void enqueued(const QueueTask::Pointer &task);
+    void dropped(int count = 1);
 
+    QString lane = QStringLiteral("queue");
     QueueTaskList penddingTasks, completedTasks;
     QMutex penddingMutex, completedMutex;
     QThread *taskThread = nullptr;
@@ -0,0 +1,294 @@
+#include "TaskStatistics.h"
+
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QtAlgorithms>
+#include <QtMath>
+#include <QMutex>
+#include <QTimer>
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(lcTaskStatistics, "mcplayer.TaskStatistics")
+
+static const int SubBucketBits = 4;
+static const int SubBucketCount = 1 << SubBucketBits;
+static const int MaxMagnitude = 40; // 2^40 us, about 12 days
+static const int BucketCount = SubBucketCount + (MaxMagnitude - SubBucketBits + 1) * SubBucketCount;
+
+/**
+ * @brief LatencyHistogram::LatencyHistogram
+ */
+LatencyHistogram::LatencyHistogram()
+    : m_counts(BucketCount, 0)
+{
+
+}
+
+int LatencyHistogram::bucketOf(qint64 usec)
+{
+    if(usec < SubBucketCount)
+        return static_cast<int>(qMax<qint64>(0, usec));
+
+    int magnitude = 63 - static_cast<int>(qCountLeadingZeroBits(quint64(usec)));
+    if(magnitude > MaxMagnitude)
+        return BucketCount - 1;
+
+    int shift = magnitude - SubBucketBits;
+    int sub = static_cast<int>((usec >> shift) & (SubBucketCount - 1));
+    return SubBucketCount + shift * SubBucketCount + sub;
+}
+
+qint64 LatencyHistogram::valueOf(int bucket)
+{
+    if(bucket < SubBucketCount)
+        return bucket;
+
+    int shift = (bucket - SubBucketCount) / SubBucketCount;
+    int sub = (bucket - SubBucketCount) % SubBucketCount;
+    return qint64(SubBucketCount + sub) << shift;
+}
+
+void LatencyHistogram::record(qint64 usec)
+{
+    usec = qMax<qint64>(0, usec);
+    ++m_counts[bucketOf(usec)];
+    m_min = m_count ? qMin(m_min, usec) : usec;
+    m_max = qMax(m_max, usec);
+    m_sum += usec;
+    ++m_count;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    if(!other.m_count)
+        return;
+
+    for(int i = 0; i < BucketCount; ++i)
+        m_counts[i] += other.m_counts[i];
+
+    m_min = m_count ? qMin(m_min, other.m_min) : other.m_min;
+    m_max = qMax(m_max, other.m_max);
+    m_sum += other.m_sum;
+    m_count += other.m_count;
+}
+
+void LatencyHistogram::reset()
+{
+    m_counts.fill(0);
+    m_count = m_sum = m_min = m_max = 0;
+}
+
+qreal LatencyHistogram::mean() const
+{
+    return m_count ? qreal(m_sum) / m_count : 0;
+}
+
+qint64 LatencyHistogram::percentile(qreal percent) const
+{
+    if(!m_count)
+        return 0;
+
+    qint64 rank = qMax<qint64>(1, qCeil(qBound<qreal>(0, percent, 100) / 100 * m_count));
+    qint64 seen = 0;
+    for(int i = 0; i < BucketCount; ++i)
+    {
+        seen += m_counts[i];
+        if(seen >= rank)
+            return qBound(min(), valueOf(i), m_max);
+    }
+
+    return m_max;
+}
+
+QJsonObject LatencyHistogram::toJson() const
+{
+    return QJsonObject
+    {
+        { "count", m_count },
+        { "min", min() },
+        { "mean", mean() },
+        { "p50", percentile(50) },
+        { "p90", percentile(90) },
+        { "p99", percentile(99) },
+        { "max", m_max }
+    };
+}
+
+QJsonObject TaskLaneSnapshot::toJson() const
+{
+    QJsonObject names;
+    for(auto it = tasks.constBegin(); it != tasks.constEnd(); ++it)
+    {
+        names.insert(it.key(), QJsonObject
+        {
+            { "wait", it.value().wait.toJson() },
+            { "run", it.value().run.toJson() }
+        });
+    }
+
+    return QJsonObject
+    {
+        { "lane", lane },
+        { "enqueued", enqueued },
+        { "started", started },
+        { "completed", completed },
+        { "canceled", canceled },
+        { "depth", depth },
+        { "tasks", names }
+    };
+}
+
+QString TaskLaneSnapshot::toString() const
+{
+    QString line = QString("lane=%1 enqueued=%2 started=%3 completed=%4 canceled=%5 depth=%6")
+            .arg(lane).arg(enqueued).arg(started).arg(completed).arg(canceled).arg(depth);
+
+    for(auto it = tasks.constBegin(); it != tasks.constEnd(); ++it)
+    {
+        const TaskLatency &latency = it.value();
+        line += QString(" | %1 n=%2 wait(p50=%3us p99=%4us max=%5us) run(p50=%6us p99=%7us max=%8us)")
+                .arg(it.key()).arg(latency.run.count())
+                .arg(latency.wait.percentile(50)).arg(latency.wait.percentile(99)).arg(latency.wait.max())
+                .arg(latency.run.percentile(50)).arg(latency.run.percentile(99)).arg(latency.run.max());
+    }
+
+    return line;
+}
+
+class TaskStatisticsPrivate
+{
+public:
+    TaskLaneSnapshot &lane(const QString &name)
+    {
+        TaskLaneSnapshot &stats = lanes[name];
+        stats.lane = name;
+        return stats;
+    }
+
+    mutable QMutex mutex;
+    QMap<QString, TaskLaneSnapshot> lanes;
+    QTimer *logTimer = nullptr;
+};
+
+/**
+ * @brief TaskStatistics::TaskStatistics
+ * @param parent
+ */
+TaskStatistics::TaskStatistics(QObject *parent)
+    : QObject(parent), d(new TaskStatisticsPrivate)
+{
+    d->logTimer = new QTimer(this);
+    connect(d->logTimer, &QTimer::timeout, this, &TaskStatistics::log);
+}
+
+TaskStatistics::~TaskStatistics()
+{
+
+}
+
+TaskStatistics *TaskStatistics::instance()
+{
+    static TaskStatistics *statistics = []()
+    {
+        TaskStatistics *stats = new TaskStatistics;
+        // the log timer must live in a thread running an event loop
+        if(QCoreApplication::instance())
+            stats->moveToThread(QCoreApplication::instance()->thread());
+        return stats;
+    }();
+
+    return statistics;
+}
+
+void TaskStatistics::taskEnqueued(const QString &lane)
+{
+    QMutexLocker lock(&d->mutex);
+    TaskLaneSnapshot &stats = d->lane(lane);
+    ++stats.enqueued;
+    ++stats.depth;
+}
+
+void TaskStatistics::taskStarted(const QString &lane, const QString &name, qint64 waitUsec)
+{
+    QMutexLocker lock(&d->mutex);
+    TaskLaneSnapshot &stats = d->lane(lane);
+    ++stats.started;
+    stats.depth = qMax<qint64>(0, stats.depth - 1);
+    stats.tasks[name].wait.record(waitUsec);
+}
+
+void TaskStatistics::taskFinished(const QString &lane, const QString &name, qint64 runUsec, bool canceled)
+{
+    QMutexLocker lock(&d->mutex);
+    TaskLaneSnapshot &stats = d->lane(lane);
+    canceled ? ++stats.canceled : ++stats.completed;
+    stats.tasks[name].run.record(runUsec);
+}
+
+void TaskStatistics::taskDropped(const QString &lane)
+{
+    QMutexLocker lock(&d->mutex);
+    TaskLaneSnapshot &stats = d->lane(lane);
+    ++stats.canceled;
+    stats.depth = qMax<qint64>(0, stats.depth - 1);
+}
+
+QList<TaskLaneSnapshot> TaskStatistics::snapshot() const
+{
+    QMutexLocker lock(&d->mutex);
+    return d->lanes.values();
+}
+
+TaskLaneSnapshot TaskStatistics::snapshot(const QString &lane) const
+{
+    QMutexLocker lock(&d->mutex);
+    TaskLaneSnapshot stats = d->lanes.value(lane);
+    stats.lane = lane;
+    return stats;
+}
+
+QJsonObject TaskStatistics::toJson() const
+{
+    QJsonArray lanes;
+    foreach (auto &stats, snapshot())
+        lanes.append(stats.toJson());
+
+    return QJsonObject{ { "lanes", lanes } };
+}
+
+void TaskStatistics::reset()
+{
+    QMutexLocker lock(&d->mutex);
+    for(auto &stats : d->lanes)
+    {
+        // keep the lane and its depth, those tasks are still in the queues
+        QString lane = stats.lane;
+        qint64 depth = stats.depth;
+        stats = TaskLaneSnapshot();
+        stats.lane = lane;
+        stats.depth = depth;
+    }
+}
+
+int TaskStatistics::logInterval() const
+{
+    return d->logTimer->isActive() ? d->logTimer->interval() : 0;
+}
+
+void TaskStatistics::setLogInterval(int msec)
+{
+    // the timer can only be started and stopped from its own thread
+    QMetaObject::invokeMethod(this, [this, msec]()
+    {
+        if(msec > 0)
+            d->logTimer->start(msec);
+        else
+            d->logTimer->stop();
+    }, Qt::QueuedConnection);
+}
+
+void TaskStatistics::log() const
+{
+    foreach (auto &stats, snapshot())
+        qInfo(lcTaskStatistics).noquote() << stats.toString();
+}
@@ -0,0 +1,105 @@
+#ifndef TASKSTATISTICS_H
+#define TASKSTATISTICS_H
+
+#include <QObject>
+#include <QVector>
+#include <QHash>
+#include <QJsonObject>
+
+/*!
+ * LatencyHistogram
+ *
+ * HDR-style histogram of durations in microseconds: values below 16 are
+ * counted exactly, larger values fall into log2 buckets split into 16 linear
+ * sub-buckets, so every recorded value keeps a relative error below 1/16.
+ */
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    void record(qint64 usec);
+    void merge(const LatencyHistogram &other);
+    void reset();
+
+    qint64 count() const { return m_count; }
+    qint64 min() const { return m_count ? m_min : 0; }
+    qint64 max() const { return m_max; }
+    qreal mean() const;
+
+    // percentile in [0, 100], the lower bound of the bucket holding it
+    qint64 percentile(qreal percent) const;
+
+    QJsonObject toJson() const;
+
+private:
+    static int bucketOf(qint64 usec);
+    static qint64 valueOf(int bucket);
+
+    QVector<quint64> m_counts;
+    qint64 m_count = 0;
+    qint64 m_sum = 0;
+    qint64 m_min = 0;
+    qint64 m_max = 0;
+};
+
+struct TaskLatency
+{
+    LatencyHistogram wait; // time spent in the queue
+    LatencyHistogram run;  // time spent in process()
+};
+
+struct TaskLaneSnapshot
+{
+    QString lane;
+    qint64 enqueued = 0;
+    qint64 started = 0;
+    qint64 completed = 0;
+    qint64 canceled = 0;
+    qint64 depth = 0;
+    QHash<QString, TaskLatency> tasks; // by AsyncTask::name() / QueueTask::name()
+
+    QJsonObject toJson() const;
+    QString toString() const;
+};
+
+/*!
+ * TaskStatistics
+ *
+ * Per-lane counters fed by AsyncTaskScheduler, QueueTaskScheduler and
+ * IdleTaskScheduler. Counters may be updated from any thread.
+ */
+class TaskStatisticsPrivate;
+class TaskStatistics : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(TaskStatistics)
+public:
+    ~TaskStatistics();
+
+    static TaskStatistics *instance();
+
+    void taskEnqueued(const QString &lane);
+    void taskStarted(const QString &lane, const QString &name, qint64 waitUsec);
+    void taskFinished(const QString &lane, const QString &name, qint64 runUsec, bool canceled = false);
+    // removed from the queue before it was started
+    void taskDropped(const QString &lane);
+
+    QList<TaskLaneSnapshot> snapshot() const;
+    TaskLaneSnapshot snapshot(const QString &lane) const;
+    QJsonObject toJson() const;
+    void reset();
+
+    // log a line per lane every msec milliseconds, 0 disables it
+    int logInterval() const;
+    void setLogInterval(int msec);
+
+public slots:
+    void log() const;
+
+private:
+    explicit TaskStatistics(QObject *parent = nullptr);
+    QScopedPointer<TaskStatisticsPrivate> d;
+};
+
+#endif // TASKSTATISTICS_H
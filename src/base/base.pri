@@ -1,6 +1,13 @@
 INCLUDEPATH += base
 
+# the library database, the maintenance lane optimizes it
+include(database/database.pri)
+
 HEADERS += \
+    $$PWD/AsyncTask.h \
+    $$PWD/DatabaseOptimizeTask.h \
+    $$PWD/IdleTaskScheduler.h \
+    $$PWD/TaskStatistics.h \
     $$PWD/Metadata.h \
     $$PWD/RuntimeError.h \
     $$PWD/global.h \
@@ -32,6 +39,10 @@ HEADERS += \
     $$PWD/vlc/VLCPlayerControl.h
 
 SOURCES += \
+    $$PWD/AsyncTask.cpp \
+    $$PWD/DatabaseOptimizeTask.cpp \
+    $$PWD/IdleTaskScheduler.cpp \
+    $$PWD/TaskStatistics.cpp \
     $$PWD/Metadata.cpp \
     $$PWD/RuntimeError.cpp \
     $$PWD/library/MediaDiscoverer.cpp \
@@ -0,0 +1,53 @@
+#ifndef BINDINGS_H
+#define BINDINGS_H
+
+#include <QVarLengthArray>
+#include <QVariant>
+
+/**
+ * @brief The Bindings class
+ * the values of a statement in place-holder order. Most statements bind a
+ * handful of values, up to 16 of them are kept inline without allocation.
+ */
+class Bindings : public QVarLengthArray<QVariant, 16>
+{
+public:
+    Bindings() { }
+    Bindings(std::initializer_list<QVariant> values)
+        : QVarLengthArray<QVariant, 16>(values) { }
+    Bindings(const QVariantList &values)
+    {
+        *this << values;
+    }
+
+    Bindings &operator<<(const QVariant &value)
+    {
+        append(value);
+        return *this;
+    }
+
+    Bindings &operator<<(const QVariantList &values)
+    {
+        reserve(size() + values.size());
+        for(const QVariant &value : values)
+            append(value);
+        return *this;
+    }
+
+    Bindings &operator<<(const Bindings &values)
+    {
+        append(values.constData(), values.size());
+        return *this;
+    }
+
+    QVariantList toList() const
+    {
+        QVariantList list;
+        list.reserve(size());
+        for(const QVariant &value : *this)
+            list.append(value);
+        return list;
+    }
+};
+
+#endif // BINDINGS_H
@@ -1,18 +1,30 @@
 #include "Connection.h"
 #include "Connection_p.h"
+#include "Database.h"
+#include "DatabaseWriter.h"
 #include "Grammar.h"
 #include "connectors/Connector.h"
 #include "query/QueryBuilder.h"
+#include "query/QueryGrammar.h"
 #include "schema/SchemaBuilder.h"
 
 #include <QUuid>
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlError>
+#include <QSqlDriver>
 #include <QJsonObject>
 #include <QSharedPointer>
+#include <QThread>
+#include <QLoggingCategory>
 #include <QDebug>
 
+Q_LOGGING_CATEGORY(lcConnection, "mcplayer.Connection")
+
+static const QString SavepointName = QStringLiteral("trans%1");
+// milliseconds to wait before the next attempt of a busy transaction, grows linearly
+static const int BusyRetryDelay = 50;
+
 /**
  * @brief Connection::Database
  */
@@ -38,6 +50,7 @@ Connection::~Connection()
 {
     Q_D(Connection);
     qDebug() << "Connection::~Connection()";
+    d->statements.clear();
     d->connector.reset(nullptr);
 }
 
@@ -80,6 +93,8 @@ void Connection::setReconnection(Connection::Closure callback)
 void Connection::setConnector(Connector *connector)
 {
     Q_D(Connection);
+    // prepared statements belong to the old database handle
+    d->statements.clear();
     // auto free old connector
     d->connector.reset(connector, &Connector::deleteLater);
     d->pdo = d->connector->connect();
@@ -88,6 +103,7 @@ void Connection::setConnector(Connector *connector)
 bool Connection::reconnect()
 {
     Q_D(Connection);
+    d->statements.clear();
     if(d->reconnection)
     {
         // lazy connection
@@ -102,6 +118,7 @@ bool Connection::reconnect()
 void Connection::disconnect()
 {
     Q_D(Connection);
+    d->statements.clear();
     d->connector->disconnect();
 }
 
@@ -137,6 +154,44 @@ Grammar *Connection::withTablePrefix(Grammar *grammar) const
     return grammar;
 }
 
+void Connection::setWriter(const QString &configuration)
+{
+    Q_D(Connection);
+    d->writer = configuration;
+}
+
+bool Connection::isWritable() const
+{
+    Q_D(const Connection);
+    return d->writer.isEmpty();
+}
+
+bool Connection::write(Connection::Closure callback)
+{
+    Q_D(Connection);
+    if(d->writer.isEmpty())
+        return callback(this);
+
+    QSqlError error(QString(), QStringLiteral("Not committed by the database writer"), QSqlError::TransactionError);
+    bool ok = Database::instance()->writer(d->writer)->run([&callback, &error](Connection *db) -> bool {
+        if(callback(db))
+            return true;
+
+        error = db->lastError();
+        return false;
+    });
+    if(!ok)
+        d->lastError = error;
+
+    return ok;
+}
+
+StatementCache *Connection::statementCache() const
+{
+    Q_D(const Connection);
+    return const_cast<StatementCache *>(&d->statements);
+}
+
 QString Connection::selectOne(const QString &query, const QStringList &bindings)
 {
     Q_UNUSED(query)
@@ -144,127 +199,381 @@ QString Connection::selectOne(const QString &query, const QStringList &bindings)
     return QString();
 }
 
-QSqlQuery Connection::select(const QString &query, const QVariantMap &bindings)
+QSqlQuery Connection::select(const QString &query, const Bindings &bindings)
+{
+    Q_D(Connection);
+    QSqlQuery sqlQuery;
+    int placeholders = 0;
+    if(!d->prepareDetached(query, sqlQuery, &placeholders))
+        return sqlQuery;
+
+    if(!d->bind(sqlQuery, placeholders, bindings))
+        return sqlQuery;
+    d->exec(sqlQuery);
+
+    return sqlQuery;
+}
+
+QSqlQuery Connection::cursor(const QString &query, const Bindings &bindings)
 {
     Q_D(Connection);
     QSqlQuery sqlQuery(d->pdo);
-    sqlQuery.prepare(query);
-    if(query.contains(QRegExp("=\\s+\\?")))
+    // must be set before prepare(), nothing of the result is buffered then
+    sqlQuery.setForwardOnly(true);
+    if(!sqlQuery.prepare(query))
     {
-        foreach (auto &val, bindings)
-            sqlQuery.addBindValue(val);
+        d->lastError = sqlQuery.lastError();
+        qWarning() << d->lastError.text();
+        return sqlQuery;
     }
 
-    if(!sqlQuery.exec())
-    {
-        qWarning() << sqlQuery.lastError().text();
-    }
+    if(!d->bind(sqlQuery, StatementCache::placeholders(query), bindings))
+        return sqlQuery;
+    d->exec(sqlQuery);
 
     return sqlQuery;
 }
 
-bool Connection::insert(const QString &query, const QVariantMap &bindings)
+bool Connection::insert(const QString &query, const Bindings &bindings)
 {
     Q_D(Connection);
-    QSqlQuery sqlQuery(d->pdo);
-    sqlQuery.prepare(query);
-    foreach (auto &val, bindings)
-        sqlQuery.addBindValue(val);
+    if(!d->writer.isEmpty())
+    {
+        return this->write([&query, &bindings](Connection *db) -> bool {
+            return db->insert(query, bindings);
+        });
+    }
+
+    QSqlQuery sqlQuery;
+    int placeholders = 0;
+    if(!d->prepare(query, sqlQuery, &placeholders))
+        return false;
+
+    if(!d->bind(sqlQuery, placeholders, bindings))
+        return false;
+
+    return d->exec(sqlQuery);
+}
 
-    bool ok;
-    if(!(ok = sqlQuery.exec()))
+QVariant Connection::insertGetId(const QString &query, const Bindings &bindings)
+{
+    Q_D(Connection);
+    if(!d->writer.isEmpty())
     {
-        qWarning() << sqlQuery.lastError().text();
+        QVariant id;
+        bool ok = this->write([&query, &bindings, &id](Connection *db) -> bool {
+            id = db->insertGetId(query, bindings);
+            return id.isValid();
+        });
+        return ok ? id : QVariant();
     }
 
-    return ok;
-    //    return this->statement(query, bindings);
+    QSqlQuery sqlQuery;
+    int placeholders = 0;
+    if(!d->prepare(query, sqlQuery, &placeholders))
+        return QVariant();
+
+    if(!d->bind(sqlQuery, placeholders, bindings))
+        return QVariant();
+    if(!d->exec(sqlQuery))
+        return QVariant();
+
+    return sqlQuery.lastInsertId();
 }
 
-bool Connection::insert(const QString &query, const QList<QVariantMap> &bindings)
+QVariant Connection::insertBatch(const QString &query, const QList<QVariantList> &rows)
 {
     Q_D(Connection);
+    if(rows.isEmpty())
+        return QVariant();
 
-    QSqlQuery sqlQuery(d->pdo);
-    sqlQuery.prepare(query);
+    if(!d->writer.isEmpty())
+    {
+        QVariant id;
+        bool ok = this->write([&query, &rows, &id](Connection *db) -> bool {
+            id = db->insertBatch(query, rows);
+            return id.isValid();
+        });
+        return ok ? id : QVariant();
+    }
+
+    QSqlQuery sqlQuery;
+    int placeholders = 0;
+    if(!d->prepare(query, sqlQuery, &placeholders))
+        return QVariant();
 
-    // batch binding
-    foreach (auto &record, bindings)
+    if(rows.first().size() != placeholders)
     {
-        foreach (auto &val, record)
-            sqlQuery.addBindValue(val);
+        qWarning() << "Can not bind rows of" << rows.first().size() << "values to" << placeholders << "placeholders of" << query;
+        return QVariant();
     }
 
-    bool ok;
-    if(!(ok = sqlQuery.exec()))
+    // execBatch() binds a list of values per place-holder
+    for(int column = 0; column < placeholders; ++column)
     {
-        qWarning() << sqlQuery.lastError().text();
+        QVariantList values;
+        values.reserve(rows.size());
+        foreach (auto &row, rows)
+            values.append(row.value(column));
+
+        sqlQuery.bindValue(column, values);
     }
 
-    // sqlQuery.lastInsertId();
+    if(!d->exec(sqlQuery, true))
+        return QVariant();
 
-    return ok;
+    return sqlQuery.lastInsertId();
 }
 
-int Connection::update(const QString &query, const QVariantMap &bindings)
+int Connection::update(const QString &query, const Bindings &bindings)
 {
     Q_D(Connection);
-    QSqlQuery sqlQuery(d->pdo);
-    sqlQuery.prepare(query);
-    if(query.contains(QRegExp("=\\s+\\?")))
+    if(!d->writer.isEmpty())
     {
-        foreach (auto &val, bindings)
-            sqlQuery.addBindValue(val);
+        int rows = -1;
+        bool ok = this->write([&query, &bindings, &rows](Connection *db) -> bool {
+            rows = db->update(query, bindings);
+            return rows >= 0;
+        });
+        return ok ? rows : -1;
     }
 
-    if(!sqlQuery.exec())
+    QSqlQuery sqlQuery;
+    int placeholders = 0;
+    if(!d->prepare(query, sqlQuery, &placeholders))
+        return -1;
+
+    if(!d->bind(sqlQuery, placeholders, bindings))
+        return -1;
+    if(!d->exec(sqlQuery))
+        return -1;
+
+    return sqlQuery.numRowsAffected();
+}
+
+int Connection::del(const QString &query, const Bindings &bindings)
+{
+    return this->update(query, bindings);
+}
+
+int Connection::statement(const QString &query, const Bindings &bindings)
+{
+    Q_D(Connection);
+    if(!bindings.isEmpty())
+        return this->affectingStatement(query, bindings) < 0 ? -1 : 0;
+
+    if(!d->writer.isEmpty())
     {
-        qWarning() << sqlQuery.lastError().text();
+        return this->write([&query](Connection *db) -> bool {
+            return db->statement(query) >= 0;
+        }) ? 0 : -1;
     }
 
-    return sqlQuery.numRowsAffected();
+    return d->statement(query) ? 0 : -1;
 }
 
-int Connection::del(const QString &query, const QVariantMap &bindings)
+int Connection::affectingStatement(const QString &query, const Bindings &bindings)
+{
+    return this->update(query, bindings);
+}
+
+bool Connection::beginTransaction(TransactionBehavior behavior)
 {
     Q_D(Connection);
-    Q_UNUSED(bindings)
+    if(d->transactions == 0)
+    {
+        // a read only connection does not take the write lock
+        if(behavior == Immediate && d->writer.isEmpty()
+                && this->driverName().compare("QSQLITE", Qt::CaseInsensitive) == 0)
+        {
+            // committed and rolled back by the driver like any other transaction
+            if(!d->statement("begin immediate"))
+                return false;
+        }
+        else if(!d->pdo.transaction())
+        {
+            d->lastError = d->pdo.lastError();
+            qWarning() << "Could not begin transaction:" << d->lastError.text();
+            return false;
+        }
+    }
+    else
+    {
+        QueryGrammar *grammar = qobject_cast<QueryGrammar *>(this->queryGrammar().get());
+        QString name = SavepointName.arg(d->transactions + 1);
+        if(!grammar || !d->statement(grammar->compileSavepoint(name)))
+            return false;
+    }
 
-    QSqlQuery sqlQuery(d->pdo);
-    sqlQuery.prepare(query);
-    if(query.contains(QRegExp("=\\s+\\?")))
+    ++d->transactions;
+    return true;
+}
+
+bool Connection::commit()
+{
+    Q_D(Connection);
+    if(d->transactions == 0)
     {
-        foreach (auto &val, bindings)
-            sqlQuery.addBindValue(val);
+        qWarning() << "Could not commit, there is no active transaction.";
+        return false;
     }
 
-    if(!sqlQuery.exec())
+    if(d->transactions == 1)
+    {
+        if(!d->pdo.commit())
+        {
+            // the transaction stays open, the caller may retry or roll back
+            d->lastError = d->pdo.lastError();
+            qWarning() << "Could not commit transaction:" << d->lastError.text();
+            return false;
+        }
+    }
+    else
     {
-        qWarning() << sqlQuery.lastError().text();
+        QueryGrammar *grammar = qobject_cast<QueryGrammar *>(this->queryGrammar().get());
+        QString name = SavepointName.arg(d->transactions);
+        if(!grammar || !d->statement(grammar->compileReleaseSavepoint(name)))
+            return false;
     }
 
-    return sqlQuery.numRowsAffected();
+    --d->transactions;
+    return true;
 }
 
-int Connection::statement(const QString &query, const QVariantMap &bindings)
+bool Connection::rollBack()
 {
     Q_D(Connection);
-    Q_UNUSED(bindings)
-    QSqlQuery sql = d->pdo.exec(query);
-    if(sql.lastError().type() != QSqlError::NoError)
+    if(d->transactions == 0)
     {
-        qWarning() << sql.lastError().text();
-        return -1;
+        qWarning() << "Could not roll back, there is no active transaction.";
+        return false;
     }
 
-    qDebug() << "execute statement ok: [" << sql.lastQuery() << "]";
+    bool ok = true;
+    if(d->transactions == 1)
+    {
+        if(!(ok = d->pdo.rollback()))
+        {
+            d->lastError = d->pdo.lastError();
+            qWarning() << "Could not roll back transaction:" << d->lastError.text();
+        }
+    }
+    else
+    {
+        QueryGrammar *grammar = qobject_cast<QueryGrammar *>(this->queryGrammar().get());
+        QString name = SavepointName.arg(d->transactions);
+        ok = grammar && d->statement(grammar->compileRollBack(name))
+                && d->statement(grammar->compileReleaseSavepoint(name));
+    }
 
-    return 0;
+    // the level is left even if it failed, it can not be used any more
+    --d->transactions;
+    return ok;
 }
 
-int Connection::affectingStatement(const QString &query, const QVariantMap &bindings)
+int Connection::transactionLevel() const
 {
-    Q_UNUSED(query)
-    Q_UNUSED(bindings)
-    return 0;
+    Q_D(const Connection);
+    return d->transactions;
+}
+
+bool Connection::transaction(Connection::Closure callback, int attempts, TransactionBehavior behavior)
+{
+    Q_D(Connection);
+    // the writer commits it, and retries it on a busy database
+    if(!d->writer.isEmpty() && d->transactions == 0)
+        return this->write(callback);
+
+    for(int attempt = 1; attempt <= qMax(1, attempts); ++attempt)
+    {
+        d->lastError = QSqlError();
+        if(!this->beginTransaction(behavior))
+        {
+            if(this->isBusy() && attempt < attempts)
+            {
+                QThread::msleep(static_cast<unsigned long>(BusyRetryDelay * attempt));
+                continue;
+            }
+            return false;
+        }
+
+        if(callback(this) && this->commit())
+            return true;
+
+        // a failed commit keeps the transaction open
+        if(d->transactions > 0)
+            this->rollBack();
+
+        // only a busy database is worth another attempt, and only as the outermost level
+        if(!this->isBusy() || d->transactions > 0)
+            return false;
+        if(attempt >= attempts)
+        {
+            if(attempts > 1)
+                qWarning() << "Database is still busy after" << attempts << "attempts:" << d->lastError.text();
+            return false;
+        }
+
+        qCDebug(lcConnection) << "Database is busy, retry transaction" << attempt << "/" << attempts;
+        QThread::msleep(static_cast<unsigned long>(BusyRetryDelay * attempt));
+    }
+
+    return false;
+}
+
+QSqlError Connection::lastError() const
+{
+    Q_D(const Connection);
+    return d->lastError;
+}
+
+bool Connection::isBusy() const
+{
+    Q_D(const Connection);
+    // SQLITE_BUSY and SQLITE_LOCKED
+    const QString code = d->lastError.nativeErrorCode();
+    return code == "5" || code == "6";
+}
+
+bool Connection::hasFeature(int feature) const
+{
+    Q_D(const Connection);
+    return d->pdo.driver() && d->pdo.driver()->hasFeature(QSqlDriver::DriverFeature(feature));
+}
+
+/**
+ * @brief TransactionGuard::TransactionGuard
+ * @param connection
+ */
+TransactionGuard::TransactionGuard(Connection *connection)
+    : m_connection(connection)
+{
+    m_active = m_connection && m_connection->beginTransaction();
+}
+
+TransactionGuard::~TransactionGuard()
+{
+    if(m_active)
+        m_connection->rollBack();
+}
+
+bool TransactionGuard::commit()
+{
+    if(!m_active)
+        return false;
+
+    if(!m_connection->commit())
+        return false;
+
+    m_active = false;
+    return true;
+}
+
+void TransactionGuard::rollBack()
+{
+    if(!m_active)
+        return;
+
+    m_connection->rollBack();
+    m_active = false;
 }
@@ -2,16 +2,16 @@
 #define CONNECTION_H
 
 #include "query/QueryBuilder.h"
+#include "Bindings.h"
 
 #include <QObject>
 #include <QSqlDatabase>
+#include <QSqlError>
 #include <QMap>
 
 /**
  * @brief
  * TODO:
- * - elapsed time query
- * - log query
  * - dispatch event
  * -
  */
@@ -19,6 +19,7 @@
 class Connector;
 class Grammar;
 class SchemaBuilder;
+class StatementCache;
 
 class ConnectionPrivate;
 class Connection
@@ -27,6 +28,12 @@ class Connection
 public:
     using Closure = std::function<bool(Connection *)>;
 
+    enum TransactionBehavior
+    {
+        Deferred,   // locks are taken by the first read or write
+        Immediate,  // the write lock is taken at begin, SQLite only
+    };
+
     explicit Connection(const QString &prefix = "");
     explicit Connection(const Connection &other);
     virtual ~Connection();
@@ -51,15 +58,73 @@ public:
     QString  tablePrefix() const;
     Grammar *withTablePrefix(Grammar *grammar) const;
 
+    /**
+     * a read only connection of a "single_writer" configuration: its writes
+     * are run by the DatabaseWriter of that configuration, see write().
+     */
+    void setWriter(const QString &configuration);
+    bool isWritable() const;
+
+    /**
+     * run callback with a connection allowed to write: this one, or the one of
+     * the single writer when this one is read only, waiting until it committed
+     * there. insert/update/del/statement do it by themselves; several writes
+     * that must be committed together go in one callback.
+     */
+    bool write(Closure callback);
+
+    // prepared statements reused by insert/update/del
+    StatementCache *statementCache() const;
+
     QString selectOne(const QString &query, const QStringList &bindings = QStringList());
-    QSqlQuery select(const QString &query, const QVariantMap &bindings = QVariantMap());
-    bool insert(const QString &query, const QVariantMap &bindings = QVariantMap());
-    bool insert(const QString &query, const QList<QVariantMap> &bindings = QList<QVariantMap>());
-    int update(const QString &query, const QVariantMap &bindings = QVariantMap());
-    int del(const QString &query, const QVariantMap &bindings = QVariantMap());
-    // execute a sql
-    int statement(const QString &query, const QVariantMap &bindings = QVariantMap());
-    int affectingStatement(const QString &query, const QVariantMap &bindings = QVariantMap());
+
+    /**
+     * the bindings are the values of the "?" place-holders in their order,
+     * their count has to match. See StatementBinder for typed values.
+     */
+
+    // the result has a statement of its own, only the other statements are cached
+    QSqlQuery select(const QString &query, const Bindings &bindings = Bindings());
+    // a forward-only result bypassing the statement cache, rows are stepped while reading
+    QSqlQuery cursor(const QString &query, const Bindings &bindings = Bindings());
+    bool insert(const QString &query, const Bindings &bindings = Bindings());
+    // returns the id of the last inserted row, an invalid value if it failed
+    QVariant insertGetId(const QString &query, const Bindings &bindings);
+    // execute a single row insert for every row of values with QSqlQuery::execBatch()
+    QVariant insertBatch(const QString &query, const QList<QVariantList> &rows);
+    // the number of affected rows, -1 if it failed
+    int update(const QString &query, const Bindings &bindings = Bindings());
+    int del(const QString &query, const Bindings &bindings = Bindings());
+    // execute a sql, 0 or -1 if it failed
+    int statement(const QString &query, const Bindings &bindings = Bindings());
+    // execute a sql, the number of affected rows or -1 if it failed
+    int affectingStatement(const QString &query, const Bindings &bindings = Bindings());
+
+    /**
+     * transactions nest: the outermost level is a database transaction,
+     * every inner level is a savepoint released by commit(). An Immediate
+     * outermost transaction reports a busy database at begin already.
+     * On a read only connection it is a read transaction, the writes made
+     * meanwhile are committed by the writer one by one.
+     */
+    bool beginTransaction(TransactionBehavior behavior = Deferred);
+    bool commit();
+    bool rollBack();
+    int transactionLevel() const;
+
+    /**
+     * run callback in a transaction, committed if it returns true and rolled
+     * back otherwise. An outermost transaction failing because the database
+     * is busy (SQLITE_BUSY/SQLITE_LOCKED) is retried up to attempts times.
+     * The outermost transaction of a read only connection is run by write().
+     */
+    bool transaction(Closure callback, int attempts = 1, TransactionBehavior behavior = Deferred);
+
+    QSqlError lastError() const;
+    // the last error was a busy or locked database
+    bool isBusy() const;
+
+    bool hasFeature(int feature) const; // QSqlDriver::DriverFeature
 
 protected:
     virtual Grammar *createScheamGrammar() = 0;
@@ -69,4 +134,25 @@ protected:
     QScopedPointer<ConnectionPrivate> d_ptr;
 };
 
+/**
+ * @brief The TransactionGuard class
+ * begins a transaction (or a savepoint) and rolls it back when it goes out
+ * of scope without commit().
+ */
+class TransactionGuard
+{
+    Q_DISABLE_COPY(TransactionGuard)
+public:
+    explicit TransactionGuard(Connection *connection);
+    ~TransactionGuard();
+
+    bool isActive() const { return m_active; }
+    bool commit();
+    void rollBack();
+
+private:
+    Connection *m_connection = nullptr;
+    bool m_active = false;
+};
+
 #endif // CONNECTION_H
@@ -8,8 +8,16 @@
 #include <QJsonObject>
 #include <QSqlDatabase>
 #include <QFile>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
 #include <QDebug>
 
+// milliseconds a thread waits for a pooled connection when the pool is full
+static const int PoolWaitTimeout = 5000;
+// only the connection of the DatabaseWriter writes to the database
+static const QString SingleWriterKey = QStringLiteral("single_writer");
+
 class ConnectionProviderPrivate
 {
 public:
@@ -48,7 +56,81 @@ public:
             jDoc = QJsonDocument::fromJson(json);
     }
 
+    Connector *connector(const QString &connectionName, const QJsonObject &config)
+    {
+        QString driver = driverOf(config);
+        if(driver.compare("qmysql", Qt::CaseInsensitive) == 0)
+        {
+            return new MySqlConnector(connectionName, config);
+        }
+        else if(driver.compare("qsqlite", Qt::CaseInsensitive) == 0)
+        {
+            return new SQLiteConnector(connectionName, config);
+        }
+
+        // TODO: throw a Invalid argument exception
+        qCritical() << "Unsupported driver:" << driver;
+        return new SQLiteConnector("");
+    }
+
+    static bool singleWriter(const QJsonObject &config)
+    {
+        return config.value(SingleWriterKey).toBool();
+    }
+
+    // the database refuses writes, they go to the writer
+    static QJsonObject readOnly(QJsonObject config)
+    {
+        QJsonObject pragmas = config.value("pragmas").toObject();
+        pragmas.insert("query_only", 1);
+        config.insert("pragmas", pragmas);
+        return config;
+    }
+
+    QString driverOf(const QJsonObject &config) const
+    {
+        QString driver = config.value("driver").toString();
+        return driver.startsWith("q") ? driver : driver.append("q");
+    }
+
+    /**
+     * @brief remove the connections of thread, must be called by that thread
+     * since the database handles can only be used by the thread created them.
+     */
+    void release(QThread *thread)
+    {
+        QMutexLocker locker(&poolMutex);
+        QObject::disconnect(watchers.take(thread));
+        QHash<QString, Connection *> connections = pool.take(thread);
+        if(connections.isEmpty())
+            return;
+
+        locker.unlock();
+
+        foreach (auto conn, connections)
+        {
+            QString connectionName = conn->connectionName();
+            conn->disconnect();
+            delete conn;
+            // no handle of the database is alive anymore
+            QSqlDatabase::removeDatabase(connectionName);
+        }
+
+        locker.relock();
+        poolSize -= connections.count();
+        released.wakeAll();
+    }
+
     QJsonDocument jDoc;
+
+    // thread => configuration name => connection
+    QHash<QThread *, QHash<QString, Connection *> > pool;
+    QHash<QThread *, QMetaObject::Connection> watchers;
+    mutable QMutex poolMutex;
+    QWaitCondition released;
+    int poolSize = 0;
+    int maxPoolSize = qMax(2, QThread::idealThreadCount() * 2);
+    quint64 serial = 0;
 };
 
 ConnectionProvider::ConnectionProvider(QObject *parent)
@@ -59,7 +141,10 @@ ConnectionProvider::ConnectionProvider(QObject *parent)
 
 ConnectionProvider::~ConnectionProvider()
 {
-
+    Q_D(ConnectionProvider);
+    // threads still alive lose their connections
+    foreach (auto thread, d->watchers.keys())
+        d->release(thread);
 }
 
 Connection *ConnectionProvider::createConnection(const QString &name)
@@ -72,6 +157,8 @@ Connection *ConnectionProvider::createConnection(const QString &name)
 
     Connection *conn = d->create(driver, prefix);
     conn->setConnector(createConnector(name));
+    if(d->singleWriter(this->configuration(name)))
+        conn->setWriter(name);
 
     return conn;
 }
@@ -85,42 +172,123 @@ Connection *ConnectionProvider::createConnection(const QString &name, const QJso
 
     Connection *conn = d->create(driver, prefix);
     conn->setConnector(createConnector(name));
+    if(d->singleWriter(this->configuration(name)))
+        conn->setWriter(name);
 
     return conn;
 }
 
 Connector *ConnectionProvider::createConnector(const QString &name)
 {
+    return this->createConnector(name, name);
+}
+
+Connector *ConnectionProvider::createConnector(const QString &name, const QString &connectionName)
+{
+    Q_D(ConnectionProvider);
     QJsonObject config = this->configuration(name);
-    QString driver = config.value("driver").toString();
-    driver = driver.startsWith("q") ? driver : driver.append("q");
+    return d->connector(connectionName, d->singleWriter(config) ? d->readOnly(config) : config);
+}
+
+void ConnectionProvider::releaseConnection(Connection *database)
+{
+    if(database)
+    {
+        database->disconnect();
+        delete database;
+    }
+}
+
+Connection *ConnectionProvider::threadConnection(const QString &name)
+{
+    return this->pooledConnection(name, false);
+}
+
+Connection *ConnectionProvider::writerConnection(const QString &name)
+{
+    return this->pooledConnection(name, true);
+}
 
-    Connector *connector = nullptr;
-    if(driver.compare("qmysql", Qt::CaseInsensitive) == 0)
+Connection *ConnectionProvider::pooledConnection(const QString &name, bool writer)
+{
+    Q_D(ConnectionProvider);
+    QThread *thread = QThread::currentThread();
+
+    QMutexLocker locker(&d->poolMutex);
+    Connection *conn = d->pool.value(thread).value(name);
+    if(conn)
     {
-        connector = new MySqlConnector(name, config);
+        if(writer && !conn->isWritable())
+            qWarning() << "The writer thread already has a read only connection:" << name;
+        return conn;
     }
-    else if(driver.compare("qsqlite", Qt::CaseInsensitive) == 0)
+
+    while(d->poolSize >= d->maxPoolSize)
     {
-        connector = new SQLiteConnector(name, config);
+        if(!d->released.wait(&d->poolMutex, PoolWaitTimeout))
+        {
+            qWarning() << "Connection pool exhausted:" << d->poolSize << "connections in use";
+            return nullptr;
+        }
     }
-    else
+
+    QString connectionName = QString("%1#%2").arg(name).arg(++d->serial);
+    ++d->poolSize;
+    if(!d->watchers.contains(thread))
     {
-        // TODO: throw a Invalid argument exception
-        qCritical() << "Unsupported driver:" << driver;
-        connector = new SQLiteConnector("");
+        // emitted by the finishing thread itself
+        d->watchers.insert(thread, connect(thread, &QThread::finished, this, [this, thread]() {
+            d_func()->release(thread);
+        }, Qt::DirectConnection));
     }
+    locker.unlock();
+
+    QJsonObject config = this->configuration(name);
+    const bool readOnly = !writer && d->singleWriter(config);
+    if(readOnly)
+        config = d->readOnly(config);
 
-    return connector;
+    conn = d->create(d->driverOf(config), config.value("prefix").toString());
+    conn->setConnector(d->connector(connectionName, config));
+    conn->setReconnection([this, connectionName, config](Connection *db) -> bool {
+        db->setConnector(d_func()->connector(connectionName, config));
+        return true;
+    });
+    if(readOnly)
+        conn->setWriter(name);
+
+    locker.relock();
+    d->pool[thread].insert(name, conn);
+
+    return conn;
 }
 
-void ConnectionProvider::releaseConnection(Connection *database)
+void ConnectionProvider::releaseThreadConnections(QThread *thread)
 {
-    if(database)
-    {
-        database->disconnect();
-        delete database;
-    }
+    Q_D(ConnectionProvider);
+    d->release(thread ? thread : QThread::currentThread());
+}
+
+int ConnectionProvider::maxPoolSize() const
+{
+    Q_D(const ConnectionProvider);
+    QMutexLocker locker(&d->poolMutex);
+    return d->maxPoolSize;
+}
+
+void ConnectionProvider::setMaxPoolSize(int size)
+{
+    Q_D(ConnectionProvider);
+    QMutexLocker locker(&d->poolMutex);
+    d->maxPoolSize = qMax(1, size);
+    d->released.wakeAll();
+}
+
+int ConnectionProvider::poolSize() const
+{
+    Q_D(const ConnectionProvider);
+    QMutexLocker locker(&d->poolMutex);
+    return d->poolSize;
 }
 
 void ConnectionProvider::addConnection(const QString &name, const QJsonObject &config)
@@ -3,6 +3,7 @@
 
 #include <QObject>
 
+class QThread;
 class Connector;
 class Connection;
 class ConnectionProviderPrivate;
@@ -11,20 +12,53 @@ class ConnectionProvider : public QObject
     Q_OBJECT
     Q_DECLARE_PRIVATE(ConnectionProvider)
 public:
+    // the milliseconds a worker keeps its pooled connections while idle
+    static const int IdleTimeout = 30000;
+
     explicit ConnectionProvider(QObject *parent = nullptr);
     ~ConnectionProvider();
 
     Connection *createConnection(const QString &name);
     Connection *createConnection(const QString &name, const QJsonObject &config);
     Connector *createConnector(const QString &name);
+    // connector of the named configuration opening the database as connectionName
+    Connector *createConnector(const QString &name, const QString &connectionName);
     void releaseConnection(Connection *database);
 
+    /**
+     * a clone of the named connection owned by the calling thread, opened
+     * lazily under a unique connection name and released when the thread
+     * finishes or releaseThreadConnections() is called. Waits for another
+     * thread to release one when the pool is full, returns nullptr if none
+     * is released in time; the caller has to check it.
+     */
+    Connection *threadConnection(const QString &name);
+    /**
+     * the pooled connection of the DatabaseWriter thread, the only one that is
+     * not read only when the configuration has "single_writer". It has to be
+     * taken before any threadConnection() of the same thread.
+     */
+    Connection *writerConnection(const QString &name);
+    /**
+     * release the pooled connections of thread, the calling thread by default.
+     * Long-lived workers (QThreadPool, the executor and writer threads) call
+     * it when they go idle, their slots are taken until they finish otherwise.
+     * Only the owning thread may release connections it still uses.
+     */
+    void releaseThreadConnections(QThread *thread = nullptr);
+
+    int maxPoolSize() const;
+    void setMaxPoolSize(int size);
+    int poolSize() const;
+
     void addConnection(const QString &name, const QJsonObject &config);
     QStringList availableDrivers() const;
     QJsonObject configuration(const QString &name) const;
     QString defaultConnection() const;
 
 private:
+    Connection *pooledConnection(const QString &name, bool writer);
+
     QScopedPointer<ConnectionProviderPrivate> d_ptr;
 };
 
@@ -2,9 +2,16 @@
 #define CONNECTION_P_H
 
 #include "Connection.h"
+#include "StatementCache.h"
+#include "QueryProfiler.h"
 
 #include <QObject>
 #include <QSharedPointer>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QDebug>
 
 class QSqlDatabase;
 class Grammar;
@@ -17,6 +24,80 @@ public:
     ConnectionPrivate(Connection *q) : q_ptr(q) {}
     virtual ~ConnectionPrivate() {}
 
+    bool prepare(const QString &sql, QSqlQuery &query, int *placeholders)
+    {
+        if(statements.prepare(pdo, sql, query, placeholders))
+            return true;
+
+        lastError = query.lastError();
+        return false;
+    }
+
+    // a select result belongs to the caller, so its statement is never shared with the cache
+    bool prepareDetached(const QString &sql, QSqlQuery &query, int *placeholders)
+    {
+        query = QSqlQuery(pdo);
+        if(!query.prepare(sql))
+        {
+            lastError = query.lastError();
+            qWarning() << lastError.text();
+            return false;
+        }
+
+        *placeholders = StatementCache::placeholders(sql);
+        return true;
+    }
+
+    bool bind(QSqlQuery &query, int placeholders, const Bindings &values)
+    {
+        if(StatementCache::bind(query, placeholders, values))
+            return true;
+
+        lastError = QSqlError(QString(), QStringLiteral("Binding count mismatch"), QSqlError::StatementError);
+        return false;
+    }
+
+    // a statement meeting a locked table is tried again after 20, 40, ... ms
+    static const int LockedAttempts = 8;
+    static const int LockedRetryDelay = 20;
+
+    bool exec(QSqlQuery &query, bool batch = false)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        bool ok = batch ? query.execBatch() : query.exec();
+        // a shared-cache table written by another connection is locked until it
+        // commits (SQLITE_LOCKED), busy_timeout only waits for a busy database
+        for(int attempt = 1; !ok && attempt < LockedAttempts && query.lastError().nativeErrorCode() == "6"; ++attempt)
+        {
+            QThread::msleep(static_cast<unsigned long>(LockedRetryDelay * attempt));
+            ok = batch ? query.execBatch() : query.exec();
+        }
+        QueryProfiler::instance()->record(pdo, query, timer.nsecsElapsed() / 1000, ok);
+        if(ok)
+            return true;
+
+        lastError = query.lastError();
+        qWarning() << lastError.text();
+        return false;
+    }
+
+    // a sql without bindings, run here even if the connection is read only
+    bool statement(const QString &sql)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        QSqlQuery query = pdo.exec(sql);
+        bool ok = query.lastError().type() == QSqlError::NoError;
+        QueryProfiler::instance()->record(pdo, query, timer.nsecsElapsed() / 1000, ok);
+        if(ok)
+            return true;
+
+        lastError = query.lastError();
+        qWarning() << lastError.text();
+        return false;
+    }
+
     Connection *q_ptr = nullptr;
 //    QSharedPointer<SchemaBuilder> schemaBuilder = nullptr;
 //    QSharedPointer<QueryBuilder> queryBuilder = nullptr;
@@ -27,6 +108,10 @@ public:
     Connection::Closure reconnection = nullptr;
     QSharedPointer<Connector> connector = nullptr;
     QString tablePrefix = ""; // The table prefix for the database table.
+    StatementCache statements;
+    QSqlError lastError;
+    int transactions = 0; // nesting level, the inner levels are savepoints
+    QString writer; // the configuration whose DatabaseWriter writes for this read only connection
 };
 
 #endif // CONNECTION_P_H
@@ -1,8 +1,13 @@
 #include "Database.h"
 #include "ConnectionProvider.h"
+#include "QueryExecutor.h"
+#include "DatabaseWriter.h"
+#include "MemoryDatabase.h"
 #include "Connection.h"
 
 #include <QJsonObject>
+#include <QThread>
+#include <QMutex>
 #include <QDebug>
 
 //Q_GLOBAL_STATIC(Database, g_instance)
@@ -37,6 +42,9 @@ public:
     }
 
     ConnectionProvider *provider = nullptr;
+    QueryExecutor *executor = nullptr;
+    QMutex writersMutex;
+    QMap<QString, DatabaseWriter *> writers;
     Connection::Closure reconnector = nullptr;
     QMap<QString, Connection *> connections;
 };
@@ -47,6 +55,7 @@ Database::Database(QObject *parent)
     Q_D(Database);
     g_instance = this;
     d->provider = new ConnectionProvider(this);
+    d->executor = new QueryExecutor(this);
     d->reconnector = [this](Connection *db) -> bool {
         return this->reconnect(db->connectionName()) != nullptr;
     };
@@ -56,10 +65,16 @@ Database::~Database()
 {
     qDebug() << "Database::~Database()";
     Q_D(Database);
+    // the executor and writer threads release their pooled connections when they stop
+    delete d->executor;
+    qDeleteAll(d->writers);
     foreach (auto conn, d->connections)
         d->provider->releaseConnection(conn);
 
     delete d->provider;
+
+    // written back once nothing writes to them any more
+    MemoryDatabase::closeAll();
 }
 
 Database *Database::instance()
@@ -85,6 +100,10 @@ Connection *Database::connection(const QString &connection)
     Q_D(Database);
 
     QString connName = connection.isEmpty() ? d->provider->defaultConnection() : connection;
+    // database handles are thread-affine, the other threads get their own
+    if(QThread::currentThread() != this->thread())
+        return d->provider->threadConnection(connName);
+
     if(!d->connections.contains(connName))
     {
         d->connections.insert(connName, d->makeConnection(connName));
@@ -97,6 +116,13 @@ Connection *Database::reconnect(const QString &connection)
 {
     Q_D(Database);
     QString connName = connection.isEmpty() ? d->provider->defaultConnection() : connection;
+    if(QThread::currentThread() != this->thread())
+    {
+        Connection *conn = d->provider->threadConnection(connName);
+        if(conn && !conn->reconnect())
+            return nullptr;
+        return conn;
+    }
     this->disconnect(connName);
 
     if(!d->connections.contains(connName))
@@ -111,6 +137,11 @@ void Database::disconnect(const QString &name)
 {
     Q_D(Database);
     QString connName = name.isEmpty() ? d->provider->defaultConnection() : name;
+    if(QThread::currentThread() != this->thread())
+    {
+        d->provider->releaseThreadConnections();
+        return;
+    }
 
     if(d->connections.contains(connName))
     {
@@ -118,6 +149,30 @@ void Database::disconnect(const QString &name)
     }
 }
 
+ConnectionProvider *Database::provider() const
+{
+    Q_D(const Database);
+    return d->provider;
+}
+
+QueryExecutor *Database::executor() const
+{
+    Q_D(const Database);
+    return d->executor;
+}
+
+DatabaseWriter *Database::writer(const QString &connection)
+{
+    Q_D(Database);
+    QString connName = connection.isEmpty() ? d->provider->defaultConnection() : connection;
+
+    QMutexLocker lock(&d->writersMutex);
+    if(!d->writers.contains(connName))
+        d->writers.insert(connName, new DatabaseWriter(connName));
+
+    return d->writers.value(connName);
+}
+
 void Database::addConnection(const QJsonObject &config, const QString &name)
 {
     Q_D(Database);
@@ -56,6 +56,8 @@
 class Connection;
 class Connector;
 class ConnectionProvider;
+class QueryExecutor;
+class DatabaseWriter;
 
 class DatabasePrivate;
 class Database : public QObject
@@ -71,11 +73,21 @@ public:
     static SchemaBuilder schema(const QString &connection = "");
 
     // get a datanase connection by specified config name, not a connection name
-    // make a connection if dose not exists
+    // make a connection if dose not exists. Threads other than the one of the
+    // database get a pooled connection of their own, see ConnectionProvider.
+    // Off the database thread it returns nullptr when the pool stays
+    // exhausted, such callers must check it and release it when idle.
     Connection *connection(const QString &connection = {});
     Connection *reconnect(const QString &connection = {});
     void disconnect(const QString &name = {});
 
+    ConnectionProvider *provider() const;
+    // the database thread running the async queries, started on first use
+    QueryExecutor *executor() const;
+    // the single writer of the named configuration, any thread may post to it,
+    // the only one writing when the configuration has "single_writer"
+    DatabaseWriter *writer(const QString &connection = {});
+
     // add a configure for new connection
     void addConnection(const QJsonObject &config, const QString &name = "default");
 
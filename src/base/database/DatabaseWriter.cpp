@@ -0,0 +1,301 @@
+#include "DatabaseWriter.h"
+#include "Database.h"
+#include "Connection.h"
+#include "ConnectionProvider.h"
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QVector>
+#include <QDeadlineTimer>
+#include <QFutureInterface>
+#include <QSharedPointer>
+#include <QLoggingCategory>
+
+#include <climits>
+
+Q_LOGGING_CATEGORY(lcDatabaseWriter, "mcplayer.DatabaseWriter")
+
+// a batch failing to commit on a busy database is retried this many times
+static const int BusyAttempts = 3;
+
+class DatabaseWriterThread : public QThread
+{
+public:
+    DatabaseWriterThread(DatabaseWriterPrivate *writer) : d(writer) {}
+
+protected:
+    void run() override;
+
+private:
+    DatabaseWriterPrivate *d = nullptr;
+};
+
+class DatabaseWriterPrivate
+{
+public:
+    struct Entry
+    {
+        DatabaseWriter::Command command;
+        QSharedPointer<QFutureInterface<bool> > promise;
+    };
+
+    void wakeThread()
+    {
+        if(!thread)
+        {
+            thread = new DatabaseWriterThread(this);
+            thread->setObjectName("DatabaseWriter");
+            thread->start();
+        }
+        ready.wakeOne();
+    }
+
+    // waits for the first command, then gathers what arrives within the window
+    QVector<Entry> takeBatch()
+    {
+        QMutexLocker lock(&mutex);
+        while(queue.isEmpty() && !stopping)
+        {
+            if(ready.wait(&mutex, holding ? ConnectionProvider::IdleTimeout : ULONG_MAX) || !holding)
+                continue;
+
+            // idle for a while, the pool slot is freed for the other threads
+            holding = false;
+            lock.unlock();
+            Database::instance()->provider()->releaseThreadConnections();
+            lock.relock();
+        }
+
+        QDeadlineTimer deadline(window);
+        while(queue.size() < maxBatch && !stopping && !urgent && !deadline.hasExpired())
+            ready.wait(&mutex, quint64(deadline.remainingTime()));
+
+        QVector<Entry> batch;
+        const int count = qMin(queue.size(), maxBatch);
+        batch.reserve(count);
+        for(int i = 0; i < count; ++i)
+            batch.append(queue.dequeue());
+        writing = batch.size();
+        urgent = urgent && !queue.isEmpty();
+
+        return batch;
+    }
+
+    /**
+     * every command in a savepoint of the one transaction of the batch. The
+     * transaction takes the write lock at begin, so a busy database is retried
+     * there; a command failing on a busy database fails the batch, which is
+     * then retried as a whole.
+     */
+    void writeBatch(Connection *connection, const QVector<Entry> &batch)
+    {
+        QVector<bool> results(batch.size(), false);
+        bool committed = connection && connection->transaction([&batch, &results](Connection *db) -> bool {
+            results.fill(false); // a busy retry runs the batch again
+            for(int i = 0; i < batch.size(); ++i)
+            {
+                TransactionGuard savepoint(db);
+                results[i] = savepoint.isActive() && batch.at(i).command(db) && savepoint.commit();
+                if(!results.at(i) && db->isBusy())
+                    return false;
+            }
+            return true;
+        }, BusyAttempts, Connection::Immediate);
+
+        if(!committed)
+        {
+            qCWarning(lcDatabaseWriter) << "Batch of" << batch.size() << "commands not written to" << name;
+            results.fill(false);
+        }
+
+        for(int i = 0; i < batch.size(); ++i)
+        {
+            batch.at(i).promise->reportResult(results.at(i));
+            batch.at(i).promise->reportFinished();
+        }
+    }
+
+    QString name;
+    DatabaseWriterThread *thread = nullptr;
+    mutable QMutex mutex;
+    QWaitCondition ready;
+    QWaitCondition idle;
+    QQueue<Entry> queue;
+    int writing = 0;
+    bool holding = false; // the writer thread has a pooled connection
+    bool stopping = false;
+    bool urgent = false; // flushed or waited for, do not wait for the window
+    int window = DatabaseWriter::DefaultWindow;
+    int maxBatch = DatabaseWriter::DefaultMaxBatch;
+};
+
+void DatabaseWriterThread::run()
+{
+    forever
+    {
+        QVector<DatabaseWriterPrivate::Entry> batch = d->takeBatch();
+        // the queued commands are still written when stopping
+        if(batch.isEmpty())
+            break;
+
+        // the connection of this thread is the only one writing
+        Connection *connection = Database::instance()->provider()->writerConnection(d->name);
+        d->holding = d->holding || connection;
+        d->writeBatch(connection, batch);
+
+        QMutexLocker lock(&d->mutex);
+        d->writing = 0;
+        if(d->queue.isEmpty())
+            d->idle.wakeAll();
+    }
+}
+
+DatabaseWriter::DatabaseWriter(const QString &connection, QObject *parent)
+    : QObject(parent), d_ptr(new DatabaseWriterPrivate)
+{
+    Q_D(DatabaseWriter);
+    d->name = connection;
+}
+
+DatabaseWriter::~DatabaseWriter()
+{
+    this->stop();
+}
+
+QString DatabaseWriter::connectionName() const
+{
+    Q_D(const DatabaseWriter);
+    return d->name;
+}
+
+QFuture<bool> DatabaseWriter::write(Command command)
+{
+    return this->enqueue(command, false);
+}
+
+QFuture<bool> DatabaseWriter::write(const QString &sql, const Bindings &bindings)
+{
+    return this->write([sql, bindings](Connection *connection) -> bool {
+        return connection->update(sql, bindings) >= 0;
+    });
+}
+
+bool DatabaseWriter::run(Command command)
+{
+    Q_D(DatabaseWriter);
+    bool writerThread = false;
+    {
+        QMutexLocker lock(&d->mutex);
+        writerThread = QThread::currentThread() == d->thread;
+    }
+
+    // a command running another one, it would wait for itself
+    if(writerThread)
+    {
+        Connection *connection = Database::instance()->provider()->writerConnection(d->name);
+        TransactionGuard savepoint(connection);
+        return savepoint.isActive() && command(connection) && savepoint.commit();
+    }
+
+    QFuture<bool> future = this->enqueue(command, true);
+    future.waitForFinished();
+    return future.result();
+}
+
+int DatabaseWriter::window() const
+{
+    Q_D(const DatabaseWriter);
+    QMutexLocker lock(&d->mutex);
+    return d->window;
+}
+
+void DatabaseWriter::setWindow(int msecs)
+{
+    Q_D(DatabaseWriter);
+    QMutexLocker lock(&d->mutex);
+    d->window = qMax(0, msecs);
+}
+
+int DatabaseWriter::maxBatch() const
+{
+    Q_D(const DatabaseWriter);
+    QMutexLocker lock(&d->mutex);
+    return d->maxBatch;
+}
+
+void DatabaseWriter::setMaxBatch(int count)
+{
+    Q_D(DatabaseWriter);
+    QMutexLocker lock(&d->mutex);
+    d->maxBatch = qMax(1, count);
+}
+
+int DatabaseWriter::pending() const
+{
+    Q_D(const DatabaseWriter);
+    QMutexLocker lock(&d->mutex);
+    return d->queue.size() + d->writing;
+}
+
+bool DatabaseWriter::flush(int msecs)
+{
+    Q_D(DatabaseWriter);
+    QDeadlineTimer deadline(msecs < 0 ? QDeadlineTimer(QDeadlineTimer::Forever) : QDeadlineTimer(msecs));
+
+    QMutexLocker lock(&d->mutex);
+    // written at once instead of at the end of the window
+    d->urgent = !d->queue.isEmpty();
+    d->ready.wakeAll();
+    while(!d->queue.isEmpty() || d->writing > 0)
+    {
+        unsigned long remaining = deadline.isForever() ? ULONG_MAX : quint64(deadline.remainingTime());
+        if(!d->idle.wait(&d->mutex, remaining))
+            return false;
+    }
+
+    return true;
+}
+
+QFuture<bool> DatabaseWriter::enqueue(Command command, bool urgent)
+{
+    Q_D(DatabaseWriter);
+    QSharedPointer<QFutureInterface<bool> > promise(new QFutureInterface<bool>);
+    promise->reportStarted();
+
+    QMutexLocker lock(&d->mutex);
+    d->queue.enqueue({command, promise});
+    // someone waits for it, the batch is written at once
+    d->urgent = d->urgent || urgent;
+    d->wakeThread();
+
+    return promise->future();
+}
+
+void DatabaseWriter::stop()
+{
+    Q_D(DatabaseWriter);
+    DatabaseWriterThread *thread = nullptr;
+    {
+        QMutexLocker lock(&d->mutex);
+        thread = d->thread;
+        if(!thread)
+            return;
+
+        d->stopping = true;
+        d->ready.wakeAll();
+    }
+
+    // the connection of the thread is released when it finishes
+    thread->wait();
+
+    QMutexLocker lock(&d->mutex);
+    delete d->thread;
+    d->thread = nullptr;
+    d->stopping = false;
+
+    // posted while stopping
+    if(!d->queue.isEmpty())
+        d->wakeThread();
+}
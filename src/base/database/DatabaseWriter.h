@@ -0,0 +1,67 @@
+#ifndef DATABASEWRITER_H
+#define DATABASEWRITER_H
+
+#include "Bindings.h"
+
+#include <QObject>
+#include <QFuture>
+
+#include <functional>
+
+class Connection;
+class DatabaseWriterPrivate;
+
+/**
+ * @brief The DatabaseWriter class
+ * the single writer of a database: it runs the write commands posted from
+ * any thread on a thread of its own. Commands arriving within the batch
+ * window are written in one transaction, each in a savepoint of its own, so
+ * a failing command does not roll back the others of its batch.
+ *
+ * A configuration with "single_writer" enforces it: its other connections
+ * are opened read only (PRAGMA query_only) and hand their writes to run(),
+ * see Connection::write(). Without it the writer is one writer among others.
+ */
+class DatabaseWriter : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(DatabaseWriter)
+public:
+    // returns false to roll back what it wrote
+    using Command = std::function<bool(Connection *connection)>;
+
+    // the milliseconds a batch waits for more commands after its first one
+    static const int DefaultWindow = 20;
+    static const int DefaultMaxBatch = 1000;
+
+    explicit DatabaseWriter(const QString &connection = {}, QObject *parent = nullptr);
+    ~DatabaseWriter() override;
+
+    QString connectionName() const;
+
+    // the future reports whether the command was committed
+    QFuture<bool> write(Command command);
+    // a single insert/update/delete statement with "?" place-holders
+    QFuture<bool> write(const QString &sql, const Bindings &bindings = Bindings());
+    // runs command without waiting for the window, returns once it is committed or failed
+    bool run(Command command);
+
+    int window() const;
+    void setWindow(int msecs);
+    int maxBatch() const;
+    void setMaxBatch(int count);
+
+    // commands queued and not written yet
+    int pending() const;
+    // wait until all the commands posted so far are written
+    bool flush(int msecs = -1);
+    // writes the queued commands and stops the thread, a later write() restarts it
+    void stop();
+
+private:
+    QFuture<bool> enqueue(Command command, bool urgent);
+
+    QScopedPointer<DatabaseWriterPrivate> d_ptr;
+};
+
+#endif // DATABASEWRITER_H
@@ -179,6 +179,28 @@ QString Grammar::dateFormat() const
     return QLatin1String("yyyy-MM-dd");
 }
 
+QVariant Grammar::bindingValue(const QVariant &value) const
+{
+    if(value.isNull())
+        return value;
+
+    switch (value.type())
+    {
+    case QVariant::Bool:
+        return int(value.toBool());
+    case QVariant::Date:
+        return value.toDate().toString(dateFormat());
+    case QVariant::Time:
+        return value.toTime().toString("HH:mm:ss");
+    case QVariant::DateTime:
+        return value.toDateTime().toString(datetimeFormat());
+    default:
+        break;
+    }
+
+    return value;
+}
+
 QString Grammar::datetimeFormat() const
 {
     return QLatin1String("yyyy-MM-dd HH:mm:ss");
@@ -52,6 +52,8 @@ public:
 
     // Get the format for database stored dates.
     virtual QString dateFormat() const;
+    // the value bound to a place-holder, dates and booleans as fromValue() inlines them
+    virtual QVariant bindingValue(const QVariant &value) const;
     virtual QString datetimeFormat() const;
 
     // Set the grammar's table prefix.
@@ -0,0 +1,758 @@
+#include "MemoryDatabase.h"
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QMap>
+#include <QPair>
+#include <QFileInfo>
+#include <QCryptographicHash>
+#include <QCoreApplication>
+#include <QDeadlineTimer>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QLoggingCategory>
+
+#include <climits>
+
+Q_LOGGING_CATEGORY(lcMemoryDatabase, "mcplayer.MemoryDatabase")
+
+// name and sql of the schema objects in creation order
+typedef QList<QPair<QString, QString> > SchemaObjects;
+
+// the rows changed since the last write-back, kept in memory only
+static const QString ChangeLog = QStringLiteral("_memory_changes");
+// the temporary tables a write-back copies the rows to, per memory table
+static const QString SnapshotPrefix = QStringLiteral("_memory_snapshot_");
+
+// a write-back meeting a locked table is tried again after 50, 100, ... ms
+static const int WriteBackAttempts = 5;
+static const unsigned long WriteBackRetryDelay = 50;
+
+static QMutex g_mutex;
+static QMap<QString, MemoryDatabase *> g_databases;
+
+static QString quoted(QString name)
+{
+    return "\"" + name.replace("\"", "\"\"") + "\"";
+}
+
+static QString literal(QString value)
+{
+    return "'" + value.replace("'", "''") + "'";
+}
+
+class MemoryDatabaseThread : public QThread
+{
+public:
+    MemoryDatabaseThread(MemoryDatabasePrivate *database) : d(database) {}
+
+protected:
+    void run() override;
+
+private:
+    MemoryDatabasePrivate *d = nullptr;
+};
+
+class MemoryDatabasePrivate
+{
+public:
+    enum State { Loading, Loaded, Failed, Stopped };
+
+    bool exec(QSqlQuery &query, const QString &sql) const
+    {
+        if(query.exec(sql))
+            return true;
+
+        qCWarning(lcMemoryDatabase) << sql << query.lastError().text();
+        return false;
+    }
+
+    // the internal sqlite_ objects and the change log are left out
+    SchemaObjects objects(QSqlQuery &query, const QString &schema, const QString &type) const
+    {
+        SchemaObjects objects;
+        query.exec(QString("select name, sql from %1.sqlite_master where type = %2 and sql is not null "
+                           "and name not like 'sqlite_%' and name not like %3 escape '\\' order by rowid")
+                   .arg(schema, literal(type), literal(QString(ChangeLog).replace("_", "\\_") + "%")));
+        while(query.next())
+            objects << qMakePair(query.value(0).toString(), query.value(1).toString());
+
+        return objects;
+    }
+
+    SchemaObjects triggers(QSqlQuery &query, const QString &schema, const QString &table) const
+    {
+        SchemaObjects triggers;
+        foreach (auto &trigger, objects(query, schema, "trigger"))
+        {
+            query.exec(QString("select tbl_name from %1.sqlite_master where name = %2").arg(schema, literal(trigger.first)));
+            if(query.next() && query.value(0).toString() == table)
+                triggers << trigger;
+        }
+
+        return triggers;
+    }
+
+    bool exists(QSqlQuery &query, const QString &schema, const QString &name) const
+    {
+        query.exec(QString("select 1 from %1.sqlite_master where name = %2").arg(schema, literal(name)));
+        return query.next();
+    }
+
+    bool hasRowId(QSqlQuery &query, const QString &schema, const QString &table) const
+    {
+        return query.exec(QString("select rowid from %1.%2 limit 0").arg(schema, quoted(table)));
+    }
+
+    static bool isVirtual(const QPair<QString, QString> &table)
+    {
+        return table.second.startsWith("create virtual", Qt::CaseInsensitive);
+    }
+
+    /**
+     * the stored columns of table, generated ones are hidden from table_info.
+     * The rowid is copied too unless an integer primary key is its alias, so
+     * both databases agree on the rows it identifies. key receives the column
+     * holding the rowid among them.
+     */
+    QString columns(QSqlQuery &query, const QString &schema, const QString &table, QString *key = nullptr) const
+    {
+        QStringList columns;
+        QString primary;
+        int keys = 0;
+        bool integerKey = false;
+        query.exec(QString("PRAGMA %1.table_info(%2)").arg(schema, quoted(table)));
+        while(query.next())
+        {
+            columns << quoted(query.value(1).toString());
+            if(query.value(5).toInt() > 0)
+            {
+                ++keys;
+                primary = columns.last();
+                integerKey = query.value(2).toString().compare("integer", Qt::CaseInsensitive) == 0;
+            }
+        }
+
+        const bool alias = keys == 1 && integerKey;
+        if(!alias && hasRowId(query, schema, table))
+            columns.prepend("rowid");
+        if(key)
+            *key = alias ? primary : QString("rowid");
+
+        return columns.join(", ");
+    }
+
+    qint64 pragma(QSqlQuery &query, const QString &name) const
+    {
+        if(query.exec("PRAGMA " + name) && query.next())
+            return query.value(0).toLongLong();
+        return -1;
+    }
+
+    /**
+     * triggers on every table of schema log the rowids they insert, update
+     * or delete to the change log, a table without rowid logs 0 and is copied
+     * in full. Virtual tables can not have triggers, they are compared.
+     *
+     * A row logged again replaces its entry with a new sequence number, so a
+     * write-back deleting the entries up to the last one it read keeps it.
+     */
+    bool track(QSqlQuery &query, const QString &schema)
+    {
+        bool tracked = exec(query, QString("create table if not exists %1.%2 (seq integer primary key, "
+                                           "tbl text not null, id integer not null, unique (tbl, id))")
+                            .arg(schema, ChangeLog));
+
+        QStringList logged;
+        query.exec(QString("select name from %1.sqlite_master where type = 'trigger' and name like %2 escape '\\'")
+                   .arg(schema, literal(QString(ChangeLog).replace("_", "\\_") + "\\_%")));
+        while(query.next())
+            logged << query.value(0).toString();
+        // dropped and made again, a renamed table keeps triggers logging its old name
+        foreach (auto &trigger, logged)
+            tracked = tracked && exec(query, QString("drop trigger %1.%2").arg(schema, quoted(trigger)));
+
+        foreach (auto &table, objects(query, schema, "table"))
+        {
+            if(isVirtual(table))
+                continue;
+
+            const bool rowid = hasRowId(query, schema, table.first);
+            auto id = [rowid](const QString &row) { return rowid ? row + ".rowid" : QString("0"); };
+            const QString log = QString("insert or replace into %1 (tbl, id) values ").arg(ChangeLog);
+            const QString name = literal(table.first);
+            const QString trigger = QString("create trigger %1.%2 after %3 on %4 begin %5; end")
+                    .arg(schema, "%1", "%2", quoted(table.first), log + "%3");
+
+            tracked = tracked
+                    && exec(query, trigger.arg(quoted(ChangeLog + "_" + table.first + "_insert"), "insert",
+                                               QString("(%1, %2)").arg(name, id("new"))))
+                    && exec(query, trigger.arg(quoted(ChangeLog + "_" + table.first + "_update"), "update",
+                                               QString("(%1, %2), (%1, %3)").arg(name, id("old"), id("new"))))
+                    && exec(query, trigger.arg(quoted(ChangeLog + "_" + table.first + "_delete"), "delete",
+                                               QString("(%1, %2)").arg(name, id("old"))));
+        }
+
+        return tracked;
+    }
+
+    // memory is the main database, the file is attached while it is copied
+    bool load(QSqlDatabase &memory)
+    {
+        QSqlQuery query(memory);
+        if(!exec(query, "attach database " + literal(file) + " as disk"))
+            return false;
+
+        bool loaded = memory.transaction();
+        // the rows first, an index is built faster on a filled table
+        foreach (auto &table, objects(query, "disk", "table"))
+        {
+            const QString columns = this->columns(query, "disk", table.first);
+            loaded = loaded && exec(query, table.second)
+                    && exec(query, QString("insert into main.%1 (%2) select %2 from disk.%1")
+                            .arg(quoted(table.first), columns));
+        }
+
+        if(loaded && exists(query, "disk", "sqlite_sequence"))
+            loaded = exec(query, "delete from main.sqlite_sequence")
+                    && exec(query, "insert into main.sqlite_sequence select * from disk.sqlite_sequence");
+
+        foreach (auto type, QStringList({"index", "view", "trigger"}))
+        {
+            foreach (auto &object, objects(query, "disk", type))
+                loaded = loaded && exec(query, object.second);
+        }
+
+        loaded = loaded && track(query, "main");
+        if(loaded)
+            loaded = memory.commit();
+        else
+            memory.rollback();
+
+        query.finish();
+        exec(query, "detach database disk");
+
+        return loaded;
+    }
+
+    /**
+     * how the snapshot of a table reaches the file: a new table or one
+     * without rowid in full, the rows of a virtual table compared and the
+     * others by the rowids logged.
+     */
+    enum CopyMode { Copy, Replace, Compare, Changes };
+
+    struct TableCopy
+    {
+        QString table;
+        CopyMode mode = Changes;
+        QString columns;
+        QString key; // the column holding the rowid
+    };
+
+    // what a write-back read from memory, kept in temporary tables of the file connection
+    struct Snapshot
+    {
+        qint64 lastChange = 0; // the last entry of the change log read
+        bool schema = false; // the schema objects below are written too
+        SchemaObjects tables;
+        SchemaObjects indexes;
+        SchemaObjects views;
+        SchemaObjects triggers;
+        QList<TableCopy> copies;
+        bool sequence = false;
+    };
+
+    static QString snapshotOf(const QString &table, const QString &suffix = QString())
+    {
+        return "temp." + quoted(SnapshotPrefix + table + suffix);
+    }
+
+    bool dropSnapshots(QSqlQuery &query)
+    {
+        QStringList tables;
+        query.exec(QString("select name from temp.sqlite_master where type = 'table' and name like %1 escape '\\'")
+                   .arg(literal(QString(SnapshotPrefix).replace("_", "\\_") + "%")));
+        while(query.next())
+            tables << query.value(0).toString();
+
+        bool dropped = true;
+        foreach (auto &table, tables)
+            dropped = exec(query, "drop table temp." + quoted(table)) && dropped;
+
+        return dropped;
+    }
+
+    // runs function in a transaction of the file connection
+    template<typename Function>
+    bool transaction(QSqlDatabase &disk, Function function)
+    {
+        if(!disk.transaction())
+        {
+            qCWarning(lcMemoryDatabase) << "Can not write back to" << file << disk.lastError().text();
+            return false;
+        }
+
+        if(function() && disk.commit())
+            return true;
+
+        disk.rollback();
+        return false;
+    }
+
+    /**
+     * copies the logged rows, and the tables to be written in full, of the
+     * memory database to temporary tables. It runs in a short transaction of
+     * its own: the shared-cache read locks it takes on the memory tables block
+     * their writers until it commits.
+     */
+    bool snapshot(QSqlQuery &query, bool schema, Snapshot &snapshot)
+    {
+        bool taken = dropSnapshots(query);
+        snapshot.tables = objects(query, "mem", "table");
+        const SchemaObjects diskTables = objects(query, "main", "table");
+        if(schema)
+        {
+            snapshot.schema = true;
+            snapshot.indexes = objects(query, "mem", "index");
+            snapshot.views = objects(query, "mem", "view");
+            snapshot.triggers = objects(query, "mem", "trigger");
+        }
+
+        taken = taken && exec(query, QString("select coalesce(max(seq), 0) from mem.%1").arg(ChangeLog)) && query.next();
+        snapshot.lastChange = taken ? query.value(0).toLongLong() : 0;
+
+        QStringList changed;
+        taken = taken && exec(query, QString("select distinct tbl from mem.%1 where seq <= %2")
+                              .arg(ChangeLog).arg(snapshot.lastChange));
+        while(taken && query.next())
+            changed << query.value(0).toString();
+
+        foreach (auto &table, snapshot.tables)
+        {
+            TableCopy copy;
+            copy.table = table.first;
+            if(schema && !diskTables.contains(table))
+                copy.mode = Copy;
+            else if(isVirtual(table))
+                copy.mode = Compare;
+            else if(!changed.contains(table.first))
+                continue;
+            else if(!hasRowId(query, "mem", table.first))
+                copy.mode = Replace;
+
+            const QString name = quoted(table.first);
+            copy.columns = columns(query, "mem", table.first, &copy.key);
+            if(copy.mode == Changes)
+            {
+                taken = taken && exec(query, QString("create table %1 as select id from mem.%2 where tbl = %3 and seq <= %4")
+                                      .arg(snapshotOf(table.first, "_ids"), ChangeLog, literal(table.first))
+                                      .arg(snapshot.lastChange))
+                        && exec(query, QString("create table %1 as select %2 from mem.%3 where rowid in (select id from %4)")
+                                .arg(snapshotOf(table.first), copy.columns, name, snapshotOf(table.first, "_ids")));
+            }
+            else
+            {
+                taken = taken && exec(query, QString("create table %1 as select %2 from mem.%3")
+                                      .arg(snapshotOf(table.first), copy.columns, name));
+            }
+
+            snapshot.copies << copy;
+        }
+
+        snapshot.sequence = exists(query, "mem", "sqlite_sequence");
+        if(snapshot.sequence)
+            taken = taken && exec(query, QString("create table %1 as select name, seq from mem.sqlite_sequence")
+                                  .arg(snapshotOf("sqlite_sequence")));
+
+        return taken;
+    }
+
+    // the snapshot of a table to the file, the triggers of the file would run again for its rows
+    bool writeTable(QSqlQuery &query, const TableCopy &copy)
+    {
+        const SchemaObjects triggers = this->triggers(query, "main", copy.table);
+        bool written = true;
+        foreach (auto &trigger, triggers)
+            written = written && exec(query, "drop trigger " + quoted(trigger.first));
+
+        const QString name = quoted(copy.table);
+        const QString rows = snapshotOf(copy.table);
+        const QString insert = QString("insert into main.%1 (%2) select %2 from %3").arg(name, copy.columns, rows);
+        switch(copy.mode)
+        {
+        case Copy:
+            written = written && exec(query, insert);
+            break;
+        case Replace:
+            written = written && exec(query, "delete from main." + name) && exec(query, insert);
+            break;
+        case Compare:
+            written = written
+                    && exec(query, QString("delete from main.%1 where rowid not in (select %2 from %3)")
+                            .arg(name, copy.key, rows))
+                    && exec(query, QString("insert or replace into main.%1 (%2) select %2 from %3 "
+                                           "except select %2 from main.%1").arg(name, copy.columns, rows));
+            break;
+        case Changes:
+            written = written
+                    && exec(query, QString("delete from main.%1 where rowid in (select id from %2)")
+                            .arg(name, snapshotOf(copy.table, "_ids")))
+                    && exec(query, insert);
+            break;
+        }
+
+        foreach (auto &trigger, triggers)
+            written = written && exec(query, trigger.second);
+
+        return written;
+    }
+
+    // the schema objects of the snapshot not in the file yet, the others are dropped
+    bool writeSchema(QSqlQuery &query, const Snapshot &snapshot)
+    {
+        bool written = true;
+
+        // the dependent objects first, a table can not be dropped under its views
+        foreach (auto &trigger, objects(query, "main", "trigger"))
+        {
+            if(!snapshot.triggers.contains(trigger))
+                written = written && exec(query, "drop trigger " + quoted(trigger.first));
+        }
+        foreach (auto &view, objects(query, "main", "view"))
+        {
+            if(!snapshot.views.contains(view))
+                written = written && exec(query, "drop view " + quoted(view.first));
+        }
+        foreach (auto &index, objects(query, "main", "index"))
+        {
+            if(!snapshot.indexes.contains(index))
+                written = written && exec(query, "drop index " + quoted(index.first));
+        }
+
+        const SchemaObjects diskTables = objects(query, "main", "table");
+        foreach (auto &table, diskTables)
+        {
+            if(!snapshot.tables.contains(table))
+                written = written && exec(query, "drop table " + quoted(table.first));
+        }
+        foreach (auto &table, snapshot.tables)
+        {
+            if(!diskTables.contains(table))
+                written = written && exec(query, table.second);
+        }
+
+        const SchemaObjects diskIndexes = objects(query, "main", "index");
+        foreach (auto &index, snapshot.indexes)
+        {
+            if(!diskIndexes.contains(index))
+                written = written && exec(query, index.second);
+        }
+        const SchemaObjects diskViews = objects(query, "main", "view");
+        foreach (auto &view, snapshot.views)
+        {
+            if(!diskViews.contains(view))
+                written = written && exec(query, view.second);
+        }
+        const SchemaObjects diskTriggers = objects(query, "main", "trigger");
+        foreach (auto &trigger, snapshot.triggers)
+        {
+            if(!diskTriggers.contains(trigger))
+                written = written && exec(query, trigger.second);
+        }
+
+        return written;
+    }
+
+    /**
+     * the file is the main database, memory is attached as "mem". Only the
+     * rows in the change log are written, and the schema when its version
+     * changed, in three steps:
+     * - snapshot() copies them to temporary tables in a short transaction
+     * - a transaction of the file writes them, it does not touch the memory
+     *   database, so no lock on it is held while the file is synced
+     * - the entries of the change log read are deleted, a row changed since
+     *   then was logged again and goes with the next write-back
+     * A failed step leaves the change log alone, the rows are written again.
+     */
+    bool writeBack(QSqlDatabase &disk)
+    {
+        QSqlQuery query(disk);
+        qint64 version = pragma(query, "mem.schema_version");
+        const bool schema = version != schemaVersion;
+
+        // the tables created in memory get their triggers before their rows are read,
+        // a table created after that changes the version again and gets them next time
+        bool written = !schema || transaction(disk, [&]() {
+            return track(query, "mem") && (version = pragma(query, "mem.schema_version")) >= 0;
+        });
+
+        Snapshot snapshot;
+        written = written && transaction(disk, [&]() { return this->snapshot(query, schema, snapshot); });
+        written = written && transaction(disk, [&]() {
+            bool ok = !snapshot.schema || writeSchema(query, snapshot);
+            foreach (auto &copy, snapshot.copies)
+                ok = ok && writeTable(query, copy);
+
+            if(ok && snapshot.sequence && exists(query, "main", "sqlite_sequence"))
+                ok = exec(query, "delete from main.sqlite_sequence")
+                        && exec(query, "insert into main.sqlite_sequence select name, seq from "
+                                + snapshotOf("sqlite_sequence"));
+            return ok;
+        });
+
+        written = written && exec(query, QString("delete from mem.%1 where seq <= %2")
+                                  .arg(ChangeLog).arg(snapshot.lastChange));
+        dropSnapshots(query);
+
+        if(written)
+            schemaVersion = version;
+        else
+            qCWarning(lcMemoryDatabase) << "Write-back to" << file << "failed, retried later";
+
+        return written;
+    }
+
+    QSqlDatabase connect(const QString &name, const QString &database) const
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", name);
+        db.setDatabaseName(database);
+        db.setConnectOptions("QSQLITE_OPEN_URI");
+        if(!db.open())
+            qCWarning(lcMemoryDatabase) << "Can not open" << database << db.lastError().text();
+
+        return db;
+    }
+
+    void setState(State value)
+    {
+        QMutexLocker lock(&mutex);
+        state = value;
+        loadFinished.wakeAll();
+        writeFinished.wakeAll();
+    }
+
+    void run()
+    {
+        const QString memoryName = "MemoryDatabase:" + uri;
+        const QString diskName = "MemoryDatabase:" + file;
+        {
+            // holds the memory database, it is freed with its last connection
+            QSqlDatabase memory = connect(memoryName, uri);
+            QSqlDatabase disk = connect(diskName, file);
+            QSqlQuery query(disk);
+
+            bool ready = memory.isOpen() && disk.isOpen() && load(memory)
+                    && exec(query, "attach database " + literal(uri) + " as mem")
+                    && exec(query, "PRAGMA busy_timeout = 5000")
+                    && exec(query, "PRAGMA synchronous = NORMAL")
+                    && exec(query, "PRAGMA temp_store = MEMORY");
+            qint64 version = pragma(query, "mem.data_version");
+            schemaVersion = pragma(query, "mem.schema_version");
+            setState(ready ? Loaded : Failed);
+            if(!ready)
+                qCWarning(lcMemoryDatabase) << "Can not load" << file << "into memory";
+
+            while(ready)
+            {
+                int requested = 0;
+                bool stop = false;
+                {
+                    QMutexLocker lock(&mutex);
+                    if(!stopping && flushRequested == flushed)
+                        wake.wait(&mutex, ulong(interval));
+                    requested = flushRequested;
+                    stop = stopping;
+                }
+
+                // a flush always writes, the interval only when something was committed
+                qint64 current = pragma(query, "mem.data_version");
+                bool ok = true;
+                if(current != version || current < 0 || requested != flushed || stop)
+                {
+                    // a table written by an open transaction is locked, wait for its commit
+                    ok = writeBack(disk);
+                    for(int attempt = 1; !ok && attempt < WriteBackAttempts; ++attempt)
+                    {
+                        QThread::msleep(WriteBackRetryDelay * attempt);
+                        ok = writeBack(disk);
+                    }
+                    if(ok)
+                        version = current;
+                }
+
+                QMutexLocker lock(&mutex);
+                flushed = requested;
+                lastWritten = ok;
+                writeFinished.wakeAll();
+                if(stop)
+                    break;
+            }
+
+            query.finish();
+            disk.close();
+            memory.close();
+        }
+
+        QSqlDatabase::removeDatabase(diskName);
+        QSqlDatabase::removeDatabase(memoryName);
+
+        QMutexLocker lock(&mutex);
+        if(state != Failed)
+            state = Stopped;
+        writeFinished.wakeAll();
+    }
+
+    QString file;
+    QString uri;
+    MemoryDatabaseThread *thread = nullptr;
+    mutable QMutex mutex;
+    QWaitCondition wake;
+    QWaitCondition loadFinished;
+    QWaitCondition writeFinished;
+    State state = Loading;
+    qint64 schemaVersion = -1; // of the memory database at the last write-back
+    int interval = MemoryDatabase::DefaultInterval;
+    int flushRequested = 0;
+    int flushed = 0;
+    bool lastWritten = true;
+    bool stopping = false;
+};
+
+void MemoryDatabaseThread::run()
+{
+    d->run();
+}
+
+MemoryDatabase::MemoryDatabase(const QString &file, int interval, QObject *parent)
+    : QObject(parent), d_ptr(new MemoryDatabasePrivate)
+{
+    Q_D(MemoryDatabase);
+    d->file = file;
+    d->interval = qMax(1, interval);
+    QByteArray key = QCryptographicHash::hash(file.toUtf8(), QCryptographicHash::Md5).toHex().left(16);
+    d->uri = "file:mcplayer-" + QString::fromLatin1(key) + "?mode=memory&cache=shared";
+
+    d->thread = new MemoryDatabaseThread(d);
+    d->thread->setObjectName("MemoryDatabase");
+    d->thread->start();
+
+    if(QCoreApplication *app = QCoreApplication::instance())
+        connect(app, &QCoreApplication::aboutToQuit, this, [this]() { this->flush(); }, Qt::DirectConnection);
+}
+
+MemoryDatabase::~MemoryDatabase()
+{
+    Q_D(MemoryDatabase);
+    this->stop();
+
+    QMutexLocker lock(&g_mutex);
+    if(g_databases.value(d->file) == this)
+        g_databases.remove(d->file);
+}
+
+MemoryDatabase *MemoryDatabase::open(const QString &file, int interval)
+{
+    const QString path = QFileInfo(file).absoluteFilePath();
+    MemoryDatabase *memory = nullptr;
+    {
+        QMutexLocker lock(&g_mutex);
+        memory = g_databases.value(path);
+        if(!memory)
+        {
+            memory = new MemoryDatabase(path, interval);
+            g_databases.insert(path, memory);
+        }
+    }
+
+    // the connections wait until the rows are there
+    MemoryDatabasePrivate *d = memory->d_func();
+    QMutexLocker lock(&d->mutex);
+    while(d->state == MemoryDatabasePrivate::Loading)
+        d->loadFinished.wait(&d->mutex);
+
+    return d->state == MemoryDatabasePrivate::Loaded ? memory : nullptr;
+}
+
+void MemoryDatabase::closeAll()
+{
+    QList<MemoryDatabase *> databases;
+    {
+        QMutexLocker lock(&g_mutex);
+        databases = g_databases.values();
+        g_databases.clear();
+    }
+
+    qDeleteAll(databases);
+}
+
+QString MemoryDatabase::file() const
+{
+    Q_D(const MemoryDatabase);
+    return d->file;
+}
+
+QString MemoryDatabase::uri() const
+{
+    Q_D(const MemoryDatabase);
+    return d->uri;
+}
+
+int MemoryDatabase::interval() const
+{
+    Q_D(const MemoryDatabase);
+    QMutexLocker lock(&d->mutex);
+    return d->interval;
+}
+
+void MemoryDatabase::setInterval(int msecs)
+{
+    Q_D(MemoryDatabase);
+    QMutexLocker lock(&d->mutex);
+    d->interval = qMax(1, msecs);
+    d->wake.wakeAll();
+}
+
+bool MemoryDatabase::flush(int msecs)
+{
+    Q_D(MemoryDatabase);
+    QDeadlineTimer deadline(msecs < 0 ? QDeadlineTimer(QDeadlineTimer::Forever) : QDeadlineTimer(msecs));
+
+    QMutexLocker lock(&d->mutex);
+    if(d->state != MemoryDatabasePrivate::Loaded)
+        return d->state == MemoryDatabasePrivate::Stopped;
+
+    const int request = ++d->flushRequested;
+    d->wake.wakeAll();
+    while(d->flushed < request && d->state == MemoryDatabasePrivate::Loaded)
+    {
+        unsigned long remaining = deadline.isForever() ? ULONG_MAX : quint64(deadline.remainingTime());
+        if(!d->writeFinished.wait(&d->mutex, remaining))
+            return false;
+    }
+
+    return d->lastWritten;
+}
+
+void MemoryDatabase::stop()
+{
+    Q_D(MemoryDatabase);
+    MemoryDatabaseThread *thread = nullptr;
+    {
+        QMutexLocker lock(&d->mutex);
+        thread = d->thread;
+        if(!thread)
+            return;
+
+        d->stopping = true;
+        d->wake.wakeAll();
+    }
+
+    thread->wait();
+
+    QMutexLocker lock(&d->mutex);
+    delete d->thread;
+    d->thread = nullptr;
+}
@@ -0,0 +1,63 @@
+#ifndef MEMORYDATABASE_H
+#define MEMORYDATABASE_H
+
+#include <QObject>
+
+class MemoryDatabasePrivate;
+
+/**
+ * @brief The MemoryDatabase class
+ * keeps an SQLite database file in a shared-cache in-memory database, the
+ * connections of a configuration with "memory": true open uri() instead of
+ * the file. The file is loaded once when the first connection opens, then
+ * the rows which changed are written back to it every interval on a thread
+ * of its own, and once more when the application quits or closeAll() is
+ * called. A crash loses the changes of the last interval at most.
+ *
+ * Triggers log the changed rowids of every table to the "_memory_changes"
+ * table of the memory database, a write-back copies only those rows, and
+ * the schema only when it changed.
+ *
+ * Shared-cache connections lock tables rather than the database: a table
+ * written by an open transaction can not be read by the others until it
+ * is committed (SQLITE_LOCKED), which busy_timeout does not wait for. A
+ * write-back only reads the memory tables in a short transaction of its
+ * own, before the file is written and synced, and a Connection retries a
+ * statement meeting a locked table a few times.
+ */
+class MemoryDatabase : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(MemoryDatabase)
+public:
+    // the milliseconds between two write-backs
+    static const int DefaultInterval = 30000;
+
+    /**
+     * the memory database of file, loaded before it is returned. nullptr if
+     * the file could not be loaded, the connection should use the file then.
+     */
+    static MemoryDatabase *open(const QString &file, int interval = DefaultInterval);
+    // writes back and closes every memory database, after their connections are released
+    static void closeAll();
+
+    ~MemoryDatabase() override;
+
+    QString file() const;
+    // the shared-cache URI to open, needs the QSQLITE_OPEN_URI option
+    QString uri() const;
+
+    int interval() const;
+    void setInterval(int msecs);
+
+    // write the changes back to the file now and wait for it
+    bool flush(int msecs = -1);
+    // writes back a last time and stops the thread
+    void stop();
+
+private:
+    explicit MemoryDatabase(const QString &file, int interval, QObject *parent = nullptr);
+    QScopedPointer<MemoryDatabasePrivate> d_ptr;
+};
+
+#endif // MEMORYDATABASE_H
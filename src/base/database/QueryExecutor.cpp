@@ -0,0 +1,145 @@
+#include "QueryExecutor.h"
+#include "Database.h"
+#include "ConnectionProvider.h"
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QDebug>
+
+#include <climits>
+
+class QueryExecutorThread : public QThread
+{
+public:
+    QueryExecutorThread(QueryExecutorPrivate *executor) : d(executor) {}
+
+protected:
+    void run() override;
+
+private:
+    QueryExecutorPrivate *d = nullptr;
+};
+
+class QueryExecutorPrivate
+{
+public:
+    struct Entry
+    {
+        QString connection;
+        QueryExecutor::Job job;
+        QueryExecutor::Failure failed;
+    };
+
+    void wakeThread()
+    {
+        if(!thread)
+        {
+            thread = new QueryExecutorThread(this);
+            thread->setObjectName("QueryExecutor");
+            thread->start();
+        }
+        ready.wakeOne();
+    }
+
+    QueryExecutorThread *thread = nullptr;
+    mutable QMutex mutex;
+    QWaitCondition ready;
+    QQueue<Entry> jobs;
+    bool stopping = false;
+};
+
+void QueryExecutorThread::run()
+{
+    bool holding = false;
+    forever
+    {
+        QueryExecutorPrivate::Entry job;
+        {
+            QMutexLocker lock(&d->mutex);
+            while(d->jobs.isEmpty() && !d->stopping)
+            {
+                if(d->ready.wait(&d->mutex, holding ? ConnectionProvider::IdleTimeout : ULONG_MAX) || !holding)
+                    continue;
+
+                // idle for a while, the pool slot is freed for the other threads
+                holding = false;
+                lock.unlock();
+                Database::instance()->provider()->releaseThreadConnections();
+                lock.relock();
+            }
+
+            // the queued jobs still run when stopping
+            if(d->jobs.isEmpty())
+                break;
+            job = d->jobs.dequeue();
+        }
+
+        // not the thread of the database, the pool gives it a connection of its own
+        Connection *connection = Database::instance()->connection(job.connection);
+        if(!connection)
+        {
+            qWarning() << "QueryExecutor: no connection for" << job.connection;
+            if(job.failed)
+                job.failed();
+            continue;
+        }
+
+        holding = true;
+        job.job(connection);
+    }
+}
+
+QueryExecutor::QueryExecutor(QObject *parent)
+    : QObject(parent), d_ptr(new QueryExecutorPrivate)
+{
+
+}
+
+QueryExecutor::~QueryExecutor()
+{
+    this->stop();
+}
+
+void QueryExecutor::post(const QString &connection, Job job, Failure failed)
+{
+    Q_D(QueryExecutor);
+    QMutexLocker lock(&d->mutex);
+    d->jobs.enqueue({connection, job, failed});
+    d->wakeThread();
+}
+
+int QueryExecutor::pending() const
+{
+    Q_D(const QueryExecutor);
+    QMutexLocker lock(&d->mutex);
+    return d->jobs.size();
+}
+
+void QueryExecutor::stop()
+{
+    Q_D(QueryExecutor);
+    QueryExecutorThread *thread = nullptr;
+    {
+        QMutexLocker lock(&d->mutex);
+        thread = d->thread;
+        if(!thread)
+            return;
+
+        d->stopping = true;
+        d->ready.wakeAll();
+    }
+
+    // the connections of the thread are released when it finishes
+    thread->wait();
+
+    QMutexLocker lock(&d->mutex);
+    delete d->thread;
+    d->thread = nullptr;
+    d->stopping = false;
+
+    // posted while stopping
+    if(!d->jobs.isEmpty())
+        d->wakeThread();
+}
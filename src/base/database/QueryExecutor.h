@@ -0,0 +1,83 @@
+#ifndef QUERYEXECUTOR_H
+#define QUERYEXECUTOR_H
+
+#include <QObject>
+#include <QFuture>
+#include <QFutureInterface>
+#include <QFutureWatcher>
+#include <QSharedPointer>
+
+#include <functional>
+
+class Connection;
+class QueryExecutorPrivate;
+
+/**
+ * @brief The QueryExecutor class
+ * runs queries one after another on a dedicated database thread, which
+ * opens a connection of its own for every configuration it is asked for.
+ * Results reach the calling thread through a QFuture, see then().
+ */
+class QueryExecutor : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(QueryExecutor)
+public:
+    using Job = std::function<void(Connection *connection)>;
+    using Failure = std::function<void()>;
+
+    explicit QueryExecutor(QObject *parent = nullptr);
+    ~QueryExecutor() override;
+
+    /**
+     * queue job for the database thread, it is called with the connection
+     * of the named configuration (the default one if empty). If that
+     * connection can not be opened the job is dropped and failed is called
+     * instead.
+     */
+    void post(const QString &connection, Job job, Failure failed = nullptr);
+
+    // the future is canceled if the connection can not be opened
+    template<typename T>
+    QFuture<T> run(const QString &connection, std::function<T(Connection *)> job)
+    {
+        QSharedPointer<QFutureInterface<T> > promise(new QFutureInterface<T>);
+        promise->reportStarted();
+        this->post(connection, [promise, job](Connection *db) {
+            promise->reportResult(job(db));
+            promise->reportFinished();
+        }, [promise]() {
+            promise->reportCanceled();
+            promise->reportFinished();
+        });
+
+        return promise->future();
+    }
+
+    /**
+     * call callback with the result of future in the thread of context once
+     * it finished, nothing is called if it was canceled or context is gone.
+     * context must live in the calling thread.
+     */
+    template<typename T>
+    static void then(const QFuture<T> &future, QObject *context, std::function<void(const T &)> callback)
+    {
+        QFutureWatcher<T> *watcher = new QFutureWatcher<T>(context);
+        QObject::connect(watcher, &QFutureWatcher<T>::finished, context, [watcher, callback]() {
+            if(!watcher->isCanceled() && watcher->future().resultCount() > 0)
+                callback(watcher->result());
+            watcher->deleteLater();
+        });
+        watcher->setFuture(future);
+    }
+
+    // jobs queued and not started yet
+    int pending() const;
+    // runs the queued jobs and stops the thread, a later post() restarts it
+    void stop();
+
+private:
+    QScopedPointer<QueryExecutorPrivate> d_ptr;
+};
+
+#endif // QUERYEXECUTOR_H
@@ -0,0 +1,320 @@
+#include "QueryProfiler.h"
+
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QJsonArray>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QLoggingCategory>
+
+#include <algorithm>
+
+Q_LOGGING_CATEGORY(lcQueryProfiler, "mcplayer.QueryProfiler")
+
+class QueryProfilerPrivate
+{
+public:
+    // the plan of a statement, flags a table read without an index
+    QStringList explain(const QSqlDatabase &database, const QString &sql, bool *scan) const
+    {
+        QStringList plan;
+        *scan = false;
+        if(database.driverName() != "QSQLITE")
+            return plan;
+
+        QString verb = sql.trimmed().section(' ', 0, 0).toLower();
+        if(!QStringList({"select", "with", "update", "delete", "insert", "replace"}).contains(verb))
+            return plan;
+
+        // the plan does not depend on the values, the place-holders stay unbound
+        QSqlQuery query(database);
+        if(!query.exec("EXPLAIN QUERY PLAN " + sql))
+        {
+            qCDebug(lcQueryProfiler) << "Could not explain:" << query.lastError().text();
+            return plan;
+        }
+
+        // id, parent, notused, detail
+        while(query.next())
+        {
+            QString detail = query.value(3).toString();
+            plan.append(detail);
+            if(isTableScan(detail))
+                *scan = true;
+        }
+
+        return plan;
+    }
+
+    // "SCAN t" or "SCAN TABLE t", but neither "SCAN t USING COVERING INDEX i",
+    // "SCAN CONSTANT ROW" nor "SCAN SUBQUERY 1" read a table row by row
+    static bool isTableScan(const QString &detail)
+    {
+        const QStringList words = detail.split(' ', QString::SkipEmptyParts);
+        if(words.size() < 2 || words.at(0) != "SCAN")
+            return false;
+
+        const QString target = words.at(1);
+        if(target == "CONSTANT" || target == "SUBQUERY" || target.startsWith('('))
+            return false;
+
+        return !words.contains("USING");
+    }
+
+    mutable QMutex mutex;
+    QHash<QString, QueryStatistics> statistics;
+    QAtomicInt enabled = 1;
+    QAtomicInt slowThreshold = QueryProfiler::DefaultSlowThreshold;
+};
+
+QueryProfiler::QueryProfiler()
+    : d(new QueryProfilerPrivate)
+{
+
+}
+
+QueryProfiler::~QueryProfiler()
+{
+
+}
+
+QueryProfiler *QueryProfiler::instance()
+{
+    static QueryProfiler profiler;
+    return &profiler;
+}
+
+/**
+ * @brief QueryProfiler::fingerprint
+ * the SQL with string and number literals replaced by "?", lists of
+ * place-holders folded into one and the white spaces collapsed.
+ */
+QString QueryProfiler::fingerprint(const QString &sql)
+{
+    QString result;
+    result.reserve(sql.size());
+
+    const int size = sql.size();
+    for(int i = 0; i < size; ++i)
+    {
+        const QChar c = sql.at(i);
+        if(c == '\'')
+        {
+            // skip to the closing quote, a doubled quote is part of the literal
+            while(++i < size)
+            {
+                if(sql.at(i) != '\'')
+                    continue;
+                if(i + 1 < size && sql.at(i + 1) == '\'')
+                    ++i;
+                else
+                    break;
+            }
+            result.append('?');
+        }
+        else if(c == '"' || c == '`')
+        {
+            int end = sql.indexOf(c, i + 1);
+            end = end < 0 ? size - 1 : end;
+            result.append(sql.midRef(i, end - i + 1));
+            i = end;
+        }
+        else if(c.isDigit() && (result.isEmpty() || !(result.at(result.size() - 1).isLetterOrNumber()
+                                                      || result.at(result.size() - 1) == '_')))
+        {
+            while(i + 1 < size && (sql.at(i + 1).isDigit() || sql.at(i + 1) == '.'))
+                ++i;
+            result.append('?');
+        }
+        else if(c.isSpace())
+        {
+            if(!result.isEmpty() && result.at(result.size() - 1) != ' ')
+                result.append(' ');
+        }
+        else
+        {
+            result.append(c);
+        }
+    }
+
+    // "in (?, ?, ?)" has the shape of "in (?)"
+    while(result.contains("?, ?"))
+        result.replace("?, ?", "?");
+
+    return result.trimmed();
+}
+
+void QueryProfiler::record(const QSqlDatabase &database, const QSqlQuery &query, qint64 usec, bool ok)
+{
+    if(!d->enabled.load())
+        return;
+
+    const QString sql = query.lastQuery();
+    const QString shape = fingerprint(sql);
+    // QSQLITE can not size a select, its rows are counted by consumed()
+    const int rows = query.isSelect() ? 0 : query.numRowsAffected();
+    const int bindings = query.boundValues().size();
+    const bool slow = usec >= qint64(d->slowThreshold.load()) * 1000;
+
+    bool explain = false;
+    {
+        QMutexLocker locker(&d->mutex);
+        QueryStatistics &stats = d->statistics[shape];
+        stats.fingerprint = shape;
+        stats.sql = sql;
+        stats.bindings = bindings;
+        stats.elapsed.record(usec);
+        ++stats.count;
+        if(!ok)
+            ++stats.failed;
+        if(rows > 0)
+            stats.rows += rows;
+        if(slow)
+        {
+            ++stats.slow;
+            explain = stats.plan.isEmpty();
+        }
+    }
+
+    qCDebug(lcQueryProfiler).noquote() << QString("%1 us").arg(usec) << bindings << "bindings" << sql;
+
+    if(!slow)
+        return;
+
+    bool scan = false;
+    QStringList plan = explain ? d->explain(database, sql, &scan) : QStringList();
+    if(explain && !plan.isEmpty())
+    {
+        QMutexLocker locker(&d->mutex);
+        QueryStatistics &stats = d->statistics[shape];
+        stats.plan = plan;
+        stats.scan = scan;
+    }
+    else
+    {
+        QMutexLocker locker(&d->mutex);
+        scan = d->statistics.value(shape).scan;
+    }
+
+    qCWarning(lcQueryProfiler).noquote() << QString("slow query %1 ms%2:").arg(usec / 1000.0, 0, 'f', 1)
+                                         .arg(scan ? " (table scan)" : "") << sql;
+    foreach (auto &detail, plan)
+        qCWarning(lcQueryProfiler).noquote() << "    " << detail;
+}
+
+void QueryProfiler::consumed(const QSqlQuery &query, qint64 rows)
+{
+    if(!d->enabled.load() || rows <= 0)
+        return;
+
+    const QString shape = fingerprint(query.lastQuery());
+    QMutexLocker locker(&d->mutex);
+    auto it = d->statistics.find(shape);
+    if(it != d->statistics.end())
+        it.value().rows += rows;
+}
+
+bool QueryProfiler::isEnabled() const
+{
+    return d->enabled.load();
+}
+
+void QueryProfiler::setEnabled(bool enabled)
+{
+    d->enabled.store(enabled ? 1 : 0);
+}
+
+int QueryProfiler::slowThreshold() const
+{
+    return d->slowThreshold.load();
+}
+
+void QueryProfiler::setSlowThreshold(int msec)
+{
+    d->slowThreshold.store(qMax(0, msec));
+}
+
+QList<QueryStatistics> QueryProfiler::statistics() const
+{
+    QList<QueryStatistics> result;
+    {
+        QMutexLocker locker(&d->mutex);
+        result = d->statistics.values();
+    }
+
+    std::sort(result.begin(), result.end(), [](const QueryStatistics &a, const QueryStatistics &b) {
+        return a.total() > b.total();
+    });
+
+    return result;
+}
+
+QueryStatistics QueryProfiler::statistics(const QString &fingerprint) const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->statistics.value(fingerprint);
+}
+
+QJsonObject QueryProfiler::toJson() const
+{
+    QJsonArray statements;
+    foreach (auto &stats, this->statistics())
+        statements.append(stats.toJson());
+
+    return QJsonObject
+    {
+        { "slowThreshold", this->slowThreshold() },
+        { "statements", statements }
+    };
+}
+
+QString QueryProfiler::toString(int limit) const
+{
+    QStringList lines;
+    lines << QString("%1 %2 %3 %4 %5 %6  %7")
+             .arg("count", 8).arg("total ms", 10).arg("p95 us", 10)
+             .arg("rows", 8).arg("slow", 6).arg("scan", 4).arg("statement");
+
+    QList<QueryStatistics> statistics = this->statistics();
+    for(int i = 0; i < statistics.size() && i < limit; ++i)
+    {
+        const QueryStatistics &stats = statistics.at(i);
+        lines << QString("%1 %2 %3 %4 %5 %6  %7")
+                 .arg(stats.count, 8).arg(stats.total() / 1000.0, 10, 'f', 1)
+                 .arg(stats.elapsed.percentile(95), 10).arg(stats.rows, 8)
+                 .arg(stats.slow, 6).arg(stats.scan ? "yes" : "", 4).arg(stats.fingerprint);
+    }
+
+    return lines.join('\n');
+}
+
+void QueryProfiler::log(int limit) const
+{
+    foreach (auto &line, this->toString(limit).split('\n'))
+        qCInfo(lcQueryProfiler).noquote() << line;
+}
+
+void QueryProfiler::reset()
+{
+    QMutexLocker locker(&d->mutex);
+    d->statistics.clear();
+}
+
+QJsonObject QueryStatistics::toJson() const
+{
+    return QJsonObject
+    {
+        { "fingerprint", fingerprint },
+        { "sql", sql },
+        { "count", count },
+        { "failed", failed },
+        { "rows", rows },
+        { "bindings", bindings },
+        { "slow", slow },
+        { "scan", scan },
+        { "plan", QJsonArray::fromStringList(plan) },
+        { "elapsed", elapsed.toJson() }
+    };
+}
@@ -0,0 +1,73 @@
+#ifndef QUERYPROFILER_H
+#define QUERYPROFILER_H
+
+#include "TaskStatistics.h"
+
+#include <QJsonObject>
+#include <QStringList>
+
+class QSqlDatabase;
+class QSqlQuery;
+
+struct QueryStatistics
+{
+    QString fingerprint;
+    QString sql;            // the last statement of this shape
+    qint64 count = 0;
+    qint64 failed = 0;
+    qint64 rows = 0;        // affected rows, or the rows read from a select
+    int bindings = 0;       // bound values of the last statement
+    qint64 slow = 0;        // executions above the threshold
+    LatencyHistogram elapsed;
+    QStringList plan;       // EXPLAIN QUERY PLAN of the first slow execution
+    bool scan = false;      // the plan scans a table without an index
+
+    qint64 total() const { return qRound64(elapsed.mean() * elapsed.count()); }
+    QJsonObject toJson() const;
+};
+
+/*!
+ * QueryProfiler
+ *
+ * Records every statement executed by a Connection grouped by its shape:
+ * the SQL with literals and "in" lists folded into place-holders. A
+ * statement slower than the threshold has its plan captured once (SQLite
+ * only) and is logged in the "mcplayer.QueryProfiler" category, flagged if
+ * it scans a table. Statements may be recorded from any thread.
+ */
+class QueryProfilerPrivate;
+class QueryProfiler
+{
+    Q_DISABLE_COPY(QueryProfiler)
+public:
+    static const int DefaultSlowThreshold = 100; // msec
+
+    ~QueryProfiler();
+
+    static QueryProfiler *instance();
+    static QString fingerprint(const QString &sql);
+
+    void record(const QSqlDatabase &database, const QSqlQuery &query, qint64 usec, bool ok);
+    // rows read from an executed select, the driver can not tell them before
+    void consumed(const QSqlQuery &query, qint64 rows);
+
+    bool isEnabled() const;
+    void setEnabled(bool enabled);
+
+    int slowThreshold() const;
+    void setSlowThreshold(int msec);
+
+    // sorted by the total elapsed time, most expensive first
+    QList<QueryStatistics> statistics() const;
+    QueryStatistics statistics(const QString &fingerprint) const;
+    QJsonObject toJson() const;
+    QString toString(int limit = 20) const;
+    void log(int limit = 20) const;
+    void reset();
+
+private:
+    QueryProfiler();
+    QScopedPointer<QueryProfilerPrivate> d;
+};
+
+#endif // QUERYPROFILER_H
@@ -0,0 +1,79 @@
+#ifndef STATEMENTBINDER_H
+#define STATEMENTBINDER_H
+
+#include "Bindings.h"
+#include "Connection.h"
+
+#include <QSqlQuery>
+
+/**
+ * @brief The StatementBinder class
+ * one statement of a connection run again and again with new values, given
+ * as typed arguments in place-holder order. The statement is prepared once
+ * by the statement cache of the connection, the bindings keep their storage
+ * between two runs.
+ *
+ *     StatementBinder played(connection, "update tracks set played_at = ?, plays = plays + 1 where id = ?");
+ *     foreach (auto id, ids)
+ *         played.update(QDateTime::currentDateTime(), id);
+ */
+class StatementBinder
+{
+public:
+    StatementBinder(Connection *connection, const QString &sql)
+        : m_connection(connection), m_sql(sql) { }
+
+    QString sql() const { return m_sql; }
+    const Bindings &bindings() const { return m_bindings; }
+
+    // the number of affected rows, -1 if it failed
+    template<typename... Values>
+    int update(const Values &... values)
+    {
+        bind(values...);
+        return m_connection->update(m_sql, m_bindings);
+    }
+
+    // the id of the inserted row, an invalid value if it failed
+    template<typename... Values>
+    QVariant insert(const Values &... values)
+    {
+        bind(values...);
+        return m_connection->insertGetId(m_sql, m_bindings);
+    }
+
+    template<typename... Values>
+    QSqlQuery select(const Values &... values)
+    {
+        bind(values...);
+        return m_connection->select(m_sql, m_bindings);
+    }
+
+private:
+    template<typename... Values>
+    void bind(const Values &... values)
+    {
+        m_bindings.clear();
+        append(values...);
+    }
+
+    void append() { }
+
+    template<typename Value, typename... Values>
+    void append(const Value &value, const Values &... values)
+    {
+        m_bindings.append(toVariant(value));
+        append(values...);
+    }
+
+    template<typename Value>
+    static QVariant toVariant(const Value &value) { return QVariant::fromValue(value); }
+    // a string literal binds as text
+    static QVariant toVariant(const char *value) { return QString::fromUtf8(value); }
+
+    Connection *m_connection = nullptr;
+    QString m_sql;
+    Bindings m_bindings;
+};
+
+#endif // STATEMENTBINDER_H
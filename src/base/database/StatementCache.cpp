@@ -0,0 +1,149 @@
+#include "StatementCache.h"
+
+#include <QSqlError>
+#include <QDebug>
+
+/**
+ * @brief StatementCache::StatementCache
+ * @param capacity
+ */
+StatementCache::StatementCache(int capacity)
+    : m_statements(qMax(1, capacity))
+{
+
+}
+
+StatementCache::StatementCache(const StatementCache &other)
+    : m_statements(other.capacity()), m_enabled(other.m_enabled)
+{
+
+}
+
+StatementCache &StatementCache::operator=(const StatementCache &other)
+{
+    if(this != &other)
+    {
+        m_statements.clear();
+        m_statements.setMaxCost(other.capacity());
+        m_enabled = other.m_enabled;
+        m_hits = m_misses = 0;
+    }
+
+    return *this;
+}
+
+StatementCache::~StatementCache()
+{
+
+}
+
+bool StatementCache::prepare(const QSqlDatabase &database, const QString &sql, QSqlQuery &query, int *placeholders)
+{
+    if(m_enabled)
+    {
+        Statement *statement = m_statements.object(sql);
+        if(statement)
+        {
+            ++m_hits;
+            query = statement->query;
+            query.finish();
+            if(placeholders)
+                *placeholders = statement->placeholders;
+            return true;
+        }
+    }
+
+    ++m_misses;
+    query = QSqlQuery(database);
+    if(!query.prepare(sql))
+    {
+        qWarning() << query.lastError().text();
+        return false;
+    }
+
+    int count = StatementCache::placeholders(sql);
+    if(placeholders)
+        *placeholders = count;
+
+    if(m_enabled)
+    {
+        Statement *statement = new Statement;
+        statement->query = query;
+        statement->placeholders = count;
+        m_statements.insert(sql, statement);
+    }
+
+    return true;
+}
+
+bool StatementCache::bind(QSqlQuery &query, int placeholders, const Bindings &values)
+{
+    // a missing value would silently keep the one of the previous execution
+    if(values.size() != placeholders)
+    {
+        qWarning() << "Can not bind" << values.size() << "values to" << placeholders << "placeholders of" << query.lastQuery();
+        return false;
+    }
+
+    for(int i = 0; i < placeholders; ++i)
+        query.bindValue(i, values.at(i));
+
+    return true;
+}
+
+int StatementCache::placeholders(const QString &sql)
+{
+    int count = 0;
+    QChar quote;
+    for(const QChar &c : sql)
+    {
+        if(!quote.isNull())
+        {
+            // a doubled quote inside a literal toggles twice and stays inside
+            if(c == quote)
+                quote = QChar();
+        }
+        else if(c == '\'' || c == '"' || c == '`')
+        {
+            quote = c;
+        }
+        else if(c == '?')
+        {
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+void StatementCache::clear()
+{
+    m_statements.clear();
+}
+
+void StatementCache::remove(const QString &sql)
+{
+    m_statements.remove(sql);
+}
+
+void StatementCache::setEnabled(bool enabled)
+{
+    m_enabled = enabled;
+    if(!enabled)
+        m_statements.clear();
+}
+
+int StatementCache::capacity() const
+{
+    return m_statements.maxCost();
+}
+
+void StatementCache::setCapacity(int capacity)
+{
+    m_statements.setMaxCost(qMax(1, capacity));
+}
+
+int StatementCache::count() const
+{
+    return m_statements.count();
+}
@@ -0,0 +1,69 @@
+#ifndef STATEMENTCACHE_H
+#define STATEMENTCACHE_H
+
+#include <QCache>
+#include <QSqlQuery>
+#include <QVariant>
+
+#include "Bindings.h"
+
+/**
+ * @brief The StatementCache class
+ * LRU cache of prepared statements of a connection, keyed by the SQL text.
+ * A cached statement is only prepared once, every execution just rebinds
+ * the positional values.
+ *
+ * Only statements whose handle the caller never sees belong here: a cached
+ * select handed out would be executed again under the rows of its reader.
+ *
+ * Copies start empty, prepared statements belong to one connection.
+ */
+class StatementCache
+{
+public:
+    static const int DefaultCapacity = 64;
+
+    explicit StatementCache(int capacity = DefaultCapacity);
+    StatementCache(const StatementCache &other);
+    StatementCache &operator=(const StatementCache &other);
+    ~StatementCache();
+
+    /**
+     * @brief prepare the query for sql on database, reusing a cached statement
+     * @param placeholders receives the number of positional placeholders
+     * @return false if the statement can not be prepared
+     */
+    bool prepare(const QSqlDatabase &database, const QString &sql, QSqlQuery &query, int *placeholders = nullptr);
+
+    // bind one value to every placeholder of the query, false if the counts differ
+    static bool bind(QSqlQuery &query, int placeholders, const Bindings &values);
+    // number of "?" outside of quoted literals and identifiers
+    static int placeholders(const QString &sql);
+
+    void clear();
+    void remove(const QString &sql);
+
+    bool isEnabled() const { return m_enabled; }
+    void setEnabled(bool enabled);
+
+    int capacity() const;
+    void setCapacity(int capacity);
+
+    int count() const;
+    qint64 hits() const { return m_hits; }
+    qint64 misses() const { return m_misses; }
+
+private:
+    struct Statement
+    {
+        QSqlQuery query;
+        int placeholders = 0;
+    };
+
+    QCache<QString, Statement> m_statements;
+    bool m_enabled = true;
+    qint64 m_hits = 0;
+    qint64 m_misses = 0;
+};
+
+#endif // STATEMENTCACHE_H
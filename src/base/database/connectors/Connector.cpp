@@ -158,7 +158,7 @@ QSqlDatabase Connector::createConnection(const QString &database, const QJsonObj
     if(d->port > 0)
         db.setPort(d->port);
     if(!opts.isEmpty())
-        db.setConnectOptions(options);
+        db.setConnectOptions(opts);
 
     db.open();
 
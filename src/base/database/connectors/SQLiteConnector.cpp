@@ -1,10 +1,21 @@
 #include "SQLiteConnector.h"
+#include "MemoryDatabase.h"
 
 #include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
 #include <QJsonObject>
 #include <QJsonValue>
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(lcSQLiteConnector, "mcplayer.SQLiteConnector")
 
 const static QString DatabaseKey      = "database";
+const static QString ProfileKey       = "profile";
+const static QString PragmasKey       = "pragmas";
+const static QString ForeignKeysKey   = "foreign_key_constraints";
+const static QString MemoryKey        = "memory";
+const static QString MemorySyncKey    = "memory_sync";
 
 SQLiteConnector::SQLiteConnector(const QString &name, QObject *parent)
     : Connector(name, parent)
@@ -17,3 +28,101 @@ SQLiteConnector::SQLiteConnector(const QString &name, const QJsonObject &config,
 {
 
 }
+
+QSqlDatabase SQLiteConnector::connect(const QJsonObject &config)
+{
+    // pragmas live as long as the connection, only a new one is tuned
+    QSqlDatabase db = QSqlDatabase::database(this->connectionName(), false);
+    if(db.isOpen())
+        return db;
+
+    QJsonObject settings = config.isEmpty() ? this->config() : config;
+    MemoryDatabase *memory = nullptr;
+    if(settings.value(MemoryKey).toBool())
+    {
+        // the file stays the home of the data, a failed load falls back to it
+        memory = MemoryDatabase::open(settings.value(DatabaseKey).toString(),
+                                      settings.value(MemorySyncKey).toInt(MemoryDatabase::DefaultInterval));
+        if(!memory)
+            qWarning() << "Can not keep" << settings.value(DatabaseKey).toString() << "in memory, using the file";
+    }
+
+    db = memory ? this->createConnection(memory->uri(), settings, "QSQLITE_OPEN_URI")
+                : Connector::connect(settings);
+    if(db.isOpen())
+        this->setPragmas(&db, settings);
+
+    return db;
+}
+
+/**
+ * @brief SQLiteConnector::profile
+ * "library": read mostly and large, WAL lets the readers run beside the
+ * writer, a big page cache and memory mapped I/O serve the browsing.
+ * "settings": small and written now and then, WAL without the big caches.
+ * NORMAL synchronous is still durable against a crash of the application
+ * in WAL mode, a power loss may roll back the last commits.
+ */
+QList<QPair<QString, QVariant> > SQLiteConnector::profile(const QString &name)
+{
+    QList<QPair<QString, QVariant> > pragmas;
+    if(name.compare("none", Qt::CaseInsensitive) == 0)
+        return pragmas;
+
+    if(name.compare("settings", Qt::CaseInsensitive) == 0)
+    {
+        pragmas << qMakePair(QString("busy_timeout"), QVariant(2000))
+                << qMakePair(QString("journal_mode"), QVariant("WAL"))
+                << qMakePair(QString("synchronous"), QVariant("NORMAL"))
+                << qMakePair(QString("cache_size"), QVariant(-2000))    // KiB
+                << qMakePair(QString("mmap_size"), QVariant(0))
+                << qMakePair(QString("temp_store"), QVariant("MEMORY"));
+        return pragmas;
+    }
+
+    if(name.compare("library", Qt::CaseInsensitive) != 0)
+        qWarning() << "Unknown SQLite profile:" << name << "using library";
+
+    pragmas << qMakePair(QString("busy_timeout"), QVariant(5000))
+            << qMakePair(QString("journal_mode"), QVariant("WAL"))
+            << qMakePair(QString("synchronous"), QVariant("NORMAL"))
+            << qMakePair(QString("cache_size"), QVariant(-32768))          // 32 MiB
+            << qMakePair(QString("mmap_size"), QVariant(268435456))        // 256 MiB
+            << qMakePair(QString("temp_store"), QVariant("MEMORY"));
+    return pragmas;
+}
+
+void SQLiteConnector::setPragmas(QSqlDatabase *db, const QJsonObject &config)
+{
+    QList<QPair<QString, QVariant> > pragmas = profile(config.value(ProfileKey).toString("library"));
+
+    // single pragmas of the configuration replace the ones of the profile
+    QJsonObject overrides = config.value(PragmasKey).toObject();
+    for(auto it = overrides.constBegin(); it != overrides.constEnd(); ++it)
+    {
+        bool replaced = false;
+        for(auto &pragma : pragmas)
+        {
+            if(pragma.first.compare(it.key(), Qt::CaseInsensitive) == 0)
+            {
+                pragma.second = it.value().toVariant();
+                replaced = true;
+            }
+        }
+        if(!replaced)
+            pragmas << qMakePair(it.key(), it.value().toVariant());
+    }
+
+    if(!config.value(ForeignKeysKey).isUndefined())
+        pragmas << qMakePair(QString("foreign_keys"), QVariant(config.value(ForeignKeysKey).toBool() ? "ON" : "OFF"));
+
+    QSqlQuery query(*db);
+    for(const auto &pragma : pragmas)
+    {
+        QString value = pragma.second.toString();
+        if(!query.exec(QString("PRAGMA %1 = %2").arg(pragma.first, value)))
+            qWarning() << "PRAGMA" << pragma.first << value << query.lastError().text();
+    }
+
+    qCDebug(lcSQLiteConnector) << "pragmas:" << this->connectionName() << pragmas.count();
+}
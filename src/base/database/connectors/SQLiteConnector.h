@@ -3,12 +3,31 @@
 
 #include "Connector.h"
 
+#include <QVariant>
+
+/**
+ * @brief The SQLiteConnector class
+ * applies a pragma profile to every newly opened connection. The "profile"
+ * of the configuration selects a preset ("library" by default, "settings"
+ * or "none"), single pragmas are overridden by the "pragmas" object and
+ * "foreign_key_constraints" turns foreign_keys on or off.
+ * "memory": true keeps the database file in memory, written back every
+ * "memory_sync" milliseconds, see MemoryDatabase.
+ */
 class SQLiteConnector : public Connector
 {
     Q_OBJECT
 public:
     explicit SQLiteConnector(const QString &name, QObject *parent = nullptr);
     SQLiteConnector(const QString &name, const QJsonObject &config, QObject *parent = nullptr);
+
+    virtual QSqlDatabase connect(const QJsonObject &config) override;
+
+    // ordered pragma name/value pairs of a preset
+    static QList<QPair<QString, QVariant> > profile(const QString &name);
+
+protected:
+    void setPragmas(QSqlDatabase *db, const QJsonObject &config);
 };
 
 #endif // SQLITECONNECTOR_H
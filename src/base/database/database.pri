@@ -1,12 +1,20 @@
-INCLUDEPATH += $$PWD
+INCLUDEPATH += \
+    $$PWD \
+    $$PWD/connectors \
+    $$PWD/query \
+    $$PWD/schema \
+    $$PWD/models \
+    $$PWD/models/relations
 
 include(helpers/helpers.pri)
 include(migrations/migrations.pri)
 
 HEADERS += \
-    $$PWD/Database.h \
-	$$PWD/DatabaseError.h
+    $$files($$PWD/*.h, true)
 
 SOURCES += \
-    $$PWD/Database.cpp \
-	$$PWD/DatabaseError.cpp
+    $$files($$PWD/*.cpp, true)
+
+# ConnectionProvider reads :/config/database.json
+RESOURCES += \
+    $$PWD/database.qrc
@@ -1,7 +1,13 @@
 #include "EloquentBuilder.h"
 #include "Model.h"
+#include "QueryProfiler.h"
 #include "query/QueryBuilder.h"
 
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QSet>
+#include <QDebug>
+
 class EloquentBuilderPrivate
 {
     Q_DECLARE_PUBLIC(EloquentBuilder)
@@ -10,9 +16,48 @@ public:
     {
     }
 
+    void eagerLoad(const QList<Model *> &models, const QStringList &relations) const
+    {
+        // "album.artist": the artists are loaded for the loaded albums
+        QMap<QString, QStringList> nested;
+        foreach (auto &relation, relations)
+        {
+            int dot = relation.indexOf('.');
+            QStringList &children = nested[dot < 0 ? relation : relation.left(dot)];
+            if(dot >= 0)
+                children.append(relation.mid(dot + 1));
+        }
+
+        for(auto it = nested.constBegin(); it != nested.constEnd(); ++it)
+        {
+            Relation relation = models.first()->relationNamed(it.key());
+            if(!relation.eagerLoad(it.key(), models) || it.value().isEmpty())
+                continue;
+
+            QList<Model *> related;
+            QSet<Model *> seen;
+            foreach (auto model, models)
+            {
+                foreach (auto object, model->relation(it.key()))
+                {
+                    Model *child = qobject_cast<Model *>(object);
+                    if(child && !seen.contains(child))
+                    {
+                        seen.insert(child);
+                        related.append(child);
+                    }
+                }
+            }
+
+            if(!related.isEmpty())
+                eagerLoad(related, it.value());
+        }
+    }
+
     EloquentBuilder *q_ptr = nullptr;
     QueryBuilder query;
     Model *model = nullptr;
+    QStringList eagerLoads;
 };
 
 EloquentBuilder::EloquentBuilder(const QueryBuilder &query, const Model *model)
@@ -20,6 +65,8 @@ EloquentBuilder::EloquentBuilder(const QueryBuilder &query, const Model *model)
 {
     d_ptr->query = query;
     d_ptr->model = const_cast<Model*>(model);
+    if(model)
+        d_ptr->query.from(model->table());
 }
 
 EloquentBuilder::EloquentBuilder(const EloquentBuilder &other)
@@ -40,6 +87,60 @@ EloquentBuilder &EloquentBuilder::where(const QString &column, const QVariant &v
     return *this;
 }
 
+EloquentBuilder &EloquentBuilder::with(const QStringList &relations)
+{
+    Q_D(EloquentBuilder);
+    foreach (auto &relation, relations)
+    {
+        if(!d->eagerLoads.contains(relation))
+            d->eagerLoads.append(relation);
+    }
+
+    return *this;
+}
+
+QStringList EloquentBuilder::eagerLoads() const
+{
+    Q_D(const EloquentBuilder);
+    return d->eagerLoads;
+}
+
+Collection EloquentBuilder::get(const QStringList &columns)
+{
+    Q_D(EloquentBuilder);
+    Collection collection;
+    if(!d->model)
+        return collection;
+
+    QList<Model *> models;
+    QSqlQuery result = d->query.cursor(columns.join(", "));
+    // the columns are mapped to the properties once for all rows
+    ModelMeta::RecordMap map = d->model->meta()->map(result.record());
+    while(result.next())
+    {
+        Model *model = d->model->newInstance(result, map);
+        if(model)
+            models.append(model);
+    }
+    QueryProfiler::instance()->consumed(result, models.size());
+
+    this->eagerLoadRelations(models);
+
+    foreach (auto model, models)
+        collection << model;
+
+    return collection;
+}
+
+void EloquentBuilder::eagerLoadRelations(const QList<Model *> &models) const
+{
+    Q_D(const EloquentBuilder);
+    if(models.isEmpty() || d->eagerLoads.isEmpty())
+        return;
+
+    d->eagerLoad(models, d->eagerLoads);
+}
+
 void EloquentBuilder::setQuery(const QueryBuilder &query)
 {
     Q_D(EloquentBuilder);
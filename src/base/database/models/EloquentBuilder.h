@@ -1,7 +1,10 @@
 #ifndef ELOQUENTBUILDER_H
 #define ELOQUENTBUILDER_H
 
+#include "Collection.h"
+
 #include <QObject>
+#include <QStringList>
 
 class Model;
 class QueryBuilder;
@@ -18,6 +21,17 @@ public:
 
     EloquentBuilder &where(const QString &column, const QVariant &value);
 
+    // relations loaded along with the models, nested by dots: "album.artist"
+    EloquentBuilder &with(const QStringList &relations);
+    QStringList eagerLoads() const;
+
+    /**
+     * the models of the query owned by the caller. every relation of with()
+     * costs one "where in" query for all of them instead of one per model.
+     */
+    Collection get(const QStringList &columns = {"*"});
+    void eagerLoadRelations(const QList<Model *> &models) const;
+
     void setQuery(const QueryBuilder &query);
     QueryBuilder query() const;
 
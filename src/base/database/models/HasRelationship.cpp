@@ -54,17 +54,6 @@ Relation HasRelationship::hasManyThrough() const
     return Relation();
 }
 
-Relation HasRelationship::belongsTo(const QString &foreignKey,
-                                    const QString localKey, const QString &relation) const
-{
-    return Relation();
-}
-
-Relation HasRelationship::belongsToMany() const
-{
-    return Relation();
-}
-
 Relation HasRelationship::morphOne() const
 {
     return Relation();
@@ -95,3 +84,43 @@ Model *HasRelationship::model() const
     Q_D(const HasRelationship);
     return d->model;
 }
+
+Model *HasRelationship::related(Model *model) const
+{
+    Q_D(const HasRelationship);
+    if(!model->connection())
+        model->setConnection(d->model->connection());
+    return model;
+}
+
+Relation HasRelationship::belongsTo(Model *related, const QString &foreignKey, const QString &ownerKey) const
+{
+    Q_D(const HasRelationship);
+    const QString fk = foreignKey.isEmpty() ? related->foreignKey() : foreignKey;
+    const QString ok = ownerKey.isEmpty() ? related->primaryKey() : ownerKey;
+
+    return BelongsTo(related, d->model, fk, ok);
+}
+
+Relation HasRelationship::belongsToMany(Model *related, const QString &table, const QString &foreignPivotKey,
+                                        const QString &relatedPivotKey, const QString &parentKey,
+                                        const QString &relatedKey) const
+{
+    Q_D(const HasRelationship);
+    QString pivot = table;
+    if(pivot.isEmpty())
+    {
+        // the joined names of both models in alphabetical order: album_track
+        QStringList names = {d->model->metaObject()->className(), related->metaObject()->className()};
+        for(auto &name : names)
+            name = name.toLower();
+        names.sort();
+        pivot = names.join("_");
+    }
+
+    return BelongsToMany(related, d->model, pivot,
+                         foreignPivotKey.isEmpty() ? d->model->foreignKey() : foreignPivotKey,
+                         relatedPivotKey.isEmpty() ? related->foreignKey() : relatedPivotKey,
+                         parentKey.isEmpty() ? d->model->primaryKey() : parentKey,
+                         relatedKey.isEmpty() ? related->primaryKey() : relatedKey);
+}
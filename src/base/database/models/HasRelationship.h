@@ -28,14 +28,7 @@ public:
     Relation hasOne(const QString &foreignKey = {}, const QString localKey = {}) const
     {
         if(std::is_base_of<Model, T>::value)
-        {
-            // TODO: input T meta data
-//            QMetaObject meta = T::staticMetaObject;
-            Model *related = new T(this->model()->parent());
-            if(!related->connection())
-                related->setConnection(this->model()->connection());
-            return this->hasOne(related, foreignKey, localKey);
-        }
+            return this->hasOne(this->related(new T), foreignKey, localKey);
 
         return Relation();
     }
@@ -45,11 +38,30 @@ public:
     Relation hasMany(const QString &foreignKey = {}, const QString localKey = {}) const
     {
         if(std::is_base_of<Model, T>::value)
-        {
-            auto related = QSharedPointer<T>::create(model()->parent());
-            related->setConnection(this->model()->connection());
-            return this->hasMany(related.get(), foreignKey, localKey);
-        }
+            return this->hasMany(this->related(new T), foreignKey, localKey);
+
+        return Relation();
+    }
+
+    //! Define an inverse one-to-one or many relationship.
+    template<typename T>
+    Relation belongsTo(const QString &foreignKey = {}, const QString ownerKey = {}) const
+    {
+        if(std::is_base_of<Model, T>::value)
+            return this->belongsTo(this->related(new T), foreignKey, ownerKey);
+
+        return Relation();
+    }
+
+    //! Define a many-to-many relationship.
+    template<typename T>
+    Relation belongsToMany(const QString &table = {}, const QString &foreignPivotKey = {},
+                           const QString &relatedPivotKey = {}, const QString &parentKey = {},
+                           const QString &relatedKey = {}) const
+    {
+        if(std::is_base_of<Model, T>::value)
+            return this->belongsToMany(this->related(new T), table, foreignPivotKey,
+                                       relatedPivotKey, parentKey, relatedKey);
 
         return Relation();
     }
@@ -59,12 +71,6 @@ public:
     //! Define a has-many-through relationship.
     Relation hasManyThrough() const;
 
-    //! Define an inverse one-to-one or many relationship.
-    Relation belongsTo(const QString &foreignKey = {},
-                       const QString localKey = {}, const QString &relation = {}) const;
-    //! Define a many-to-many relationship.
-    Relation belongsToMany() const;
-
     //! Define a polymorphic one-to-one relationship.
     Relation morphOne() const;
     //! Define a polymorphic, inverse one-to-one or many relationship.
@@ -78,8 +84,14 @@ public:
 
 private:
     Model *model() const;
+    // the related model of a new relation, owned by the relation
+    Model *related(Model *model) const;
     Relation hasOne(Model *related, const QString &foreignKey = {}, const QString localKey = {}) const;
     Relation hasMany(Model *related, const QString &foreignKey = {}, const QString localKey = {}) const;
+    Relation belongsTo(Model *related, const QString &foreignKey, const QString &ownerKey) const;
+    Relation belongsToMany(Model *related, const QString &table, const QString &foreignPivotKey,
+                           const QString &relatedPivotKey, const QString &parentKey,
+                           const QString &relatedKey) const;
 
 private:
     QScopedPointer<HasRelationshipPrivate> d_ptr;
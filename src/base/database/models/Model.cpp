@@ -1,10 +1,14 @@
 #include "Model.h"
 #include "Connection.h"
 #include "EloquentBuilder.h"
+#include "query/QueryBuilder.h"
+#include "query/QueryGrammar.h"
 
 #include <QMetaProperty>
 #include <QMetaMethod>
 #include <QJsonDocument>
+#include <QSqlRecord>
+#include <QSqlQuery>
 #include <QDebug>
 
 class ModelPrivate : public QSharedData
@@ -13,33 +17,25 @@ class ModelPrivate : public QSharedData
 public:
     ModelPrivate(Model *q) : q_ptr(q), relationship(q) {}
 
-    QJsonObject propertyToJson(const QMetaProperty &property) const
+    QJsonObject propertyToJson(const ModelMeta::Property &prop) const
     {
         Q_Q(const Model);
         const QMetaObject *meta = q->metaObject();
-        QString slot;
-        for(int i = 0; i < meta->methodCount(); ++i)
-        {
-            slot = meta->method(i).name();
-            if(slot.toLower().endsWith(property.name()))
-                break;
-
-            slot = "";
-        }
+        const QMetaProperty &property = prop.property;
 
         return QJsonObject
         {
             { "index", property.propertyIndex() },
-            { "name", property.name() },
+            { "name", prop.name },
             { "type", property.type() },
             { "typeName", property.typeName() },
             { "value", QJsonValue::fromVariant(property.read(q)) },
 //            { "defaultValue", "NULL" }, //!
-            { "auto", q->primaryKey() == property.name() }, //!
+            { "auto", q->primaryKey() == prop.name }, //!
             { "table", q->table() }, //!
             { "signal", QString(property.notifySignal().name())  },
-            { "slot", slot },
-            { "method", property.name() }, //  TODO: find correct method
+            { "slot", prop.slot },
+            { "method", prop.name }, //  TODO: find correct method
             { "readable", property.isReadable() },
             { "writable", property.isWritable() },
             { "resetable", property.isResettable() },
@@ -52,15 +48,283 @@ public:
         };
     }
 
-    bool tapProperty(Model const *model, std::function<void(const QMetaProperty &property)> method) const
+    bool tapProperty(Model const *model, std::function<void(const ModelMeta::Property &property)> method) const
+    {
+        for(const auto &property : ModelMeta::of(model->metaObject())->properties())
+            method(property);
+
+        return true;
+    }
+
+    // write value to the property at position, what it holds then is remembered
+    void writeProperty(const ModelMeta *meta, int position, const QVariant &value)
+    {
+        Q_Q(Model);
+        if(written.size() != meta->properties().size())
+            written.resize(meta->properties().size());
+
+        Written &entry = written[position];
+        entry.valid = meta->write(q, position, value, &entry.value);
+    }
+
+    /**
+     * the values of the columns now. The attributes keep the raw values, a
+     * NULL stays NULL, unless the setter of a property changed it since the
+     * attribute was written to it. The properties of the columns a query did
+     * not select are not tracked, neither are those of a new model still at
+     * the value of a fresh instance: the database default applies to them.
+     */
+    QVariantMap currentAttributes() const
+    {
+        Q_Q(const Model);
+        const ModelMeta *meta = q->meta();
+        const QVector<ModelMeta::Property> &properties = meta->properties();
+        const QVariantMap defaults = exists ? QVariantMap() : meta->defaults();
+
+        QVariantMap current = attributes;
+        for(int i = 0; i < properties.size(); ++i)
+        {
+            const ModelMeta::Property &property = properties.at(i);
+            const QVariant value = property.property.read(q);
+            if(i < written.size() && written.at(i).valid)
+            {
+                if(value != written.at(i).value)
+                    current.insert(property.name, value);
+            }
+            else if(exists ? current.contains(property.name) : value != defaults.value(property.name))
+            {
+                current.insert(property.name, value);
+            }
+        }
+
+        return current;
+    }
+
+    // the current values become the original ones, the properties hold them
+    void sync()
+    {
+        Q_Q(Model);
+        attributes = currentAttributes();
+        originalAttributes = attributes;
+
+        const QVector<ModelMeta::Property> &properties = q->meta()->properties();
+        written.fill(Written(), properties.size());
+        for(int i = 0; i < properties.size(); ++i)
+        {
+            const ModelMeta::Property &property = properties.at(i);
+            if(!attributes.contains(property.name))
+                continue;
+
+            written[i].value = property.property.read(q);
+            written[i].valid = true;
+        }
+    }
+
+    /**
+     * the columns differing from the original ones. A new model has all of
+     * its set columns dirty, but a NULL incrementing key the database generates.
+     */
+    QVariantMap dirty(const QVariantMap &current) const
     {
-        const QMetaObject *meta = model->metaObject();
-         // skip properties in the class's superclasses
-        const int offset = meta->propertyOffset();
-        const int count = meta->propertyCount();
+        Q_Q(const Model);
+        if(!exists)
+        {
+            QVariantMap dirty = current;
+            const QString key = q->primaryKey();
+            if(incrementing && dirty.value(key).isNull())
+                dirty.remove(key);
+            return dirty;
+        }
 
-        for (int i = offset; i < count; ++i)
-            method(meta->property(i));
+        QVariantMap dirty;
+        for(auto it = current.constBegin(); it != current.constEnd(); ++it)
+        {
+            auto found = originalAttributes.constFind(it.key());
+            if(found == originalAttributes.constEnd() || !equivalent(it.value(), found.value()))
+                dirty.insert(it.key(), it.value());
+        }
+
+        return dirty;
+    }
+
+    // the raw value of the database and the one of the property may differ in type
+    static bool equivalent(const QVariant &current, const QVariant &original)
+    {
+        // a null variant compares equal to the default value of its type
+        if(current.isNull() || original.isNull())
+            return current.isNull() && original.isNull();
+        if(current == original)
+            return true;
+
+        QVariant converted = original;
+        return converted.convert(current.userType()) && converted == current;
+    }
+
+    // the row of the model, by the key it was read with
+    QVariant updateKey() const
+    {
+        Q_Q(const Model);
+        const QString key = q->primaryKey();
+        return originalAttributes.value(key, attributes.value(key));
+    }
+
+    bool performUpdate(Connection *db, const QVariantMap &dirty)
+    {
+        Q_Q(Model);
+        return db->queryBuilder().from(q->table()).where(q->primaryKey(), "=", updateKey()).update(dirty) >= 0;
+    }
+
+    /**
+     * the models of one table with the same dirty columns in one statement
+     * per chunk, every column set by a "case <key> when <id> then <value>".
+     */
+    static bool performUpdates(Connection *connection, const QList<QPair<Model *, QVariantMap> > &group)
+    {
+        if(group.size() == 1)
+            return group.first().first->d_func()->performUpdate(connection, group.first().second);
+
+        Model *model = group.first().first;
+        QSharedPointer<Grammar> grammar = connection->queryGrammar();
+        QueryGrammar *queryGrammar = qobject_cast<QueryGrammar *>(grammar.data());
+        const QString key = grammar->wrap(model->primaryKey());
+        const QStringList columns = group.first().second.keys();
+        const int maxBindings = queryGrammar ? queryGrammar->maxBindings() : 999;
+        const int chunk = qMax(1, maxBindings / (2 * columns.size() + 1));
+
+        for(int start = 0; start < group.size(); start += chunk)
+        {
+            const int end = qMin(start + chunk, group.size());
+            Bindings bindings;
+            QStringList sets;
+            foreach (auto &column, columns)
+            {
+                QString set = grammar->wrap(column) + " = case " + key;
+                for(int i = start; i < end; ++i)
+                {
+                    set += " when ? then ?";
+                    bindings << group.at(i).first->d_func()->updateKey() << group.at(i).second.value(column);
+                }
+                sets << set + " end";
+            }
+
+            QStringList keys;
+            for(int i = start; i < end; ++i)
+            {
+                keys << "?";
+                bindings << group.at(i).first->d_func()->updateKey();
+            }
+
+            const QString sql = QString("update %1 set %2 where %3 in (%4)")
+                    .arg(grammar->wrapTable(model->table()), sets.join(", "), key, keys.join(", "));
+            if(connection->update(sql, bindings) < 0)
+                return false;
+        }
+
+        return true;
+    }
+
+    // the model exists from now on, with the generated id unless it had one
+    void inserted(const QVariantMap &values, const QVariant &id)
+    {
+        Q_Q(Model);
+        exists = true;
+        const QString key = q->primaryKey();
+        if(incrementing && !values.contains(key) && id.isValid())
+            q->setAttribute(key, id);
+        q->syncOriginal();
+    }
+
+    /**
+     * the models are grouped by table and dirty columns, the new ones of a
+     * group are one chunked multi-row insert, the existing ones a chunked
+     * update. The models learn their ids and originals once all of it committed.
+     */
+    static bool saveMany(const Collection &objects, bool insertOnly)
+    {
+        struct Inserts
+        {
+            QList<Model *> models;
+            QList<QVariantMap> rows;
+        };
+        QMap<QString, Inserts> inserts;
+        QMap<QString, QList<QPair<Model *, QVariantMap> > > updates;
+        Connection *connection = nullptr;
+
+        foreach (QObject *object, objects)
+        {
+            Model *model = qobject_cast<Model *>(object);
+            if(!model)
+                continue;
+
+            ModelPrivate *d = model->d_func();
+            if(!connection)
+                connection = d->connection;
+            if(!d->connection || d->connection != connection)
+            {
+                qWarning() << "The models saved together need the same connection:" << model->table();
+                return false;
+            }
+
+            const QVariantMap dirty = d->dirty(d->currentAttributes());
+            const QString group = model->table() + ":" + QStringList(dirty.keys()).join(",");
+            if(d->exists)
+            {
+                if(insertOnly)
+                {
+                    qWarning() << "insertMany() of an existing model:" << model->table() << model->primaryValue();
+                    return false;
+                }
+                if(!dirty.isEmpty())
+                    updates[group] << qMakePair(model, dirty);
+            }
+            else if(!dirty.isEmpty())
+            {
+                inserts[group].models << model;
+                inserts[group].rows << dirty;
+            }
+        }
+
+        if(!connection)
+            return true;
+
+        // one transaction, on the writer when the connection is read only
+        QList<QVariantList> ids;
+        bool written = connection->write([&inserts, &updates, &ids](Connection *db) -> bool {
+            TransactionGuard transaction(db);
+
+            ids.clear();
+            foreach (auto &group, inserts)
+            {
+                Model *model = group.models.first();
+                ids << db->queryBuilder().from(model->table()).insertGetIds(group.rows, model->primaryKey());
+                if(ids.last().size() != group.rows.size())
+                    return false;
+            }
+
+            foreach (auto &group, updates)
+            {
+                if(!performUpdates(db, group))
+                    return false;
+            }
+
+            return !transaction.isActive() || transaction.commit();
+        });
+        if(!written)
+            return false;
+
+        int index = 0;
+        foreach (auto &group, inserts)
+        {
+            const QVariantList &groupIds = ids.at(index++);
+            for(int i = 0; i < group.models.size(); ++i)
+                group.models.at(i)->d_func()->inserted(group.rows.at(i), groupIds.at(i));
+        }
+
+        foreach (auto &group, updates)
+        {
+            for(const auto &update : group)
+                update.first->syncOriginal();
+        }
 
         return true;
     }
@@ -82,6 +346,15 @@ public:
     QStringList fillable = {};
     QVariantMap attributes;
     QVariantMap originalAttributes;
+
+    // what a property was set to from its attribute, by property position
+    struct Written
+    {
+        QVariant value;
+        bool valid = false;
+    };
+    QVector<Written> written;
+    QHash<QString, QList<QSharedPointer<Model> > > relations; // The loaded relationships.
 };
 
 Model::Model(QObject *parent)
@@ -98,7 +371,6 @@ Model::Model(const Relation &relation, QObject *parent)
 
 Model::~Model()
 {
-    qDebug() << "~Model(): free";
 }
 
 QString Model::table() const
@@ -130,15 +402,44 @@ QString Model::foreignKey() const
 bool Model::save()
 {
     Q_D(Model);
-    if(d->attributes.isEmpty())
+    if(!d->connection)
+        return false;
+
+    const QVariantMap dirty = this->getDirty();
+    if(d->exists)
+    {
+        // nothing changed, no statement
+        if(dirty.isEmpty())
+            return true;
+
+        if(!d->performUpdate(d->connection, dirty))
+            return false;
+
+        this->syncOriginal();
+        return true;
+    }
+
+    if(dirty.isEmpty())
         return false;
 
-    // TODO:
-    // query->insert(d->attributes);
+    QVariantList ids = d->connection->queryBuilder().from(this->table()).insertGetIds({dirty}, this->primaryKey());
+    if(ids.isEmpty())
+        return false;
 
+    d->inserted(dirty, ids.first());
     return true;
 }
 
+bool Model::saveMany(const Collection &models)
+{
+    return ModelPrivate::saveMany(models, false);
+}
+
+bool Model::insertMany(const Collection &models)
+{
+    return ModelPrivate::saveMany(models, true);
+}
+
 bool Model::update(const QVariantMap &attributes)
 {
     Q_D(const Model);
@@ -218,6 +519,35 @@ void Model::setAttribute(const QString &key, const QVariant &value)
 {
     Q_D(Model);
     d->attributes.insert(key, value);
+
+    const ModelMeta *meta = this->meta();
+    int position = meta->indexOf(key);
+    if(position >= 0)
+        d->writeProperty(meta, position, value);
+}
+
+bool Model::isDirty(const QString &key) const
+{
+    const QVariantMap dirty = this->getDirty();
+    return key.isEmpty() ? !dirty.isEmpty() : dirty.contains(key);
+}
+
+QVariantMap Model::getDirty() const
+{
+    Q_D(const Model);
+    return d->dirty(d->currentAttributes());
+}
+
+QVariantMap Model::original() const
+{
+    Q_D(const Model);
+    return d->originalAttributes;
+}
+
+void Model::syncOriginal()
+{
+    Q_D(Model);
+    d->sync();
 }
 
 QJsonObject Model::attributesToJson() const
@@ -225,13 +555,134 @@ QJsonObject Model::attributesToJson() const
     return QJsonObject();
 }
 
+void Model::setRawAttributes(const QVariantMap &attributes, bool sync)
+{
+    Q_D(Model);
+    d->attributes = attributes;
+    if(sync)
+        d->originalAttributes = attributes;
+    d->exists = true;
+    d->written.clear();
+
+    const ModelMeta *meta = this->meta();
+    for(auto it = attributes.constBegin(); it != attributes.constEnd(); ++it)
+    {
+        int position = meta->indexOf(it.key());
+        if(position >= 0)
+            d->writeProperty(meta, position, it.value());
+    }
+}
+
+bool Model::exists() const
+{
+    Q_D(const Model);
+    return d->exists;
+}
+
+Model *Model::newInstance(const QVariantMap &attributes) const
+{
+    // needs the Q_INVOKABLE constructor of the class
+    Model *model = qobject_cast<Model *>(this->meta()->create());
+    if(!model)
+    {
+        qWarning() << "No invokable constructor:" << this->metaObject()->className();
+        return nullptr;
+    }
+
+    model->setConnection(this->connection());
+    if(!attributes.isEmpty())
+        model->setRawAttributes(attributes);
+
+    return model;
+}
+
+Model *Model::newInstance(const QSqlRecord &record) const
+{
+    ModelMeta::RecordMap map = this->meta()->map(record);
+
+    QVariantMap attributes;
+    for(int i = 0; i < record.count(); ++i)
+        attributes.insert(map.fields.at(i), record.value(i));
+
+    return this->newInstance(attributes);
+}
+
+Model *Model::newInstance(const QSqlQuery &query, const ModelMeta::RecordMap &map) const
+{
+    const ModelMeta *meta = this->meta();
+    Model *model = qobject_cast<Model *>(meta->create());
+    if(!model)
+    {
+        qWarning() << "No invokable constructor:" << this->metaObject()->className();
+        return nullptr;
+    }
+
+    model->setConnection(this->connection());
+
+    ModelPrivate *d = model->d_func();
+    d->exists = true;
+    const int count = map.fields.size();
+    for(int i = 0; i < count; ++i)
+    {
+        const QVariant value = query.value(i);
+        d->attributes.insert(map.fields.at(i), value);
+
+        const int position = map.properties.at(i);
+        if(position >= 0)
+            d->writeProperty(meta, position, value);
+    }
+    d->originalAttributes = d->attributes;
+
+    return model;
+}
+
+const ModelMeta *Model::meta() const
+{
+    return ModelMeta::of(this->metaObject());
+}
+
+Relation Model::relationNamed(const QString &name) const
+{
+    Relation relation;
+    Model *self = const_cast<Model *>(this);
+    if(!QMetaObject::invokeMethod(self, name.toLatin1().constData(), Qt::DirectConnection,
+                                  Q_RETURN_ARG(Relation, relation)))
+    {
+        qWarning() << "Undefined relation:" << this->metaObject()->className() << name;
+    }
+
+    return relation;
+}
+
+Collection Model::relation(const QString &name) const
+{
+    Q_D(const Model);
+    Collection models;
+    foreach (auto &model, d->relations.value(name))
+        models << model.data();
+
+    return models;
+}
+
+void Model::setRelation(const QString &name, const QList<QSharedPointer<Model> > &models)
+{
+    Q_D(Model);
+    d->relations.insert(name, models);
+}
+
+bool Model::relationLoaded(const QString &name) const
+{
+    Q_D(const Model);
+    return d->relations.contains(name);
+}
+
 QHash<QString, QMetaProperty> Model::metaProperty() const
 {
     Q_D(const Model);
     QHash<QString, QMetaProperty> properties;
-    d->tapProperty(this, [&properties](const QMetaProperty &property)
+    d->tapProperty(this, [&properties](const ModelMeta::Property &property)
     {
-        properties.insert(property.name(), property);
+        properties.insert(property.name, property.property);
     });
 
     return properties;
@@ -241,10 +692,10 @@ QJsonObject Model::metaPropertyToJson() const
 {
     Q_D(const Model);
     QJsonObject result;
-    d->tapProperty(this, [&result, d](const QMetaProperty &property)
+    d->tapProperty(this, [&result, d](const ModelMeta::Property &property)
     {
         QJsonObject json = d->propertyToJson(property);
-        result.insert(property.name(), QJsonValue(json));
+        result.insert(property.name, QJsonValue(json));
     });
 
     return result;
@@ -265,7 +716,25 @@ void Model::setConnection(Connection *connection)
 EloquentBuilder Model::newQuery() const
 {
     Q_D(const Model);
-    return EloquentBuilder(d->connection->queryBuilder(), this);
+    EloquentBuilder query(d->connection->queryBuilder(), this);
+    if(!d->with.isEmpty())
+        query.with(d->with);
+
+    return query;
+}
+
+EloquentBuilder Model::with(const QStringList &relations) const
+{
+    EloquentBuilder query = this->newQuery();
+    query.with(relations);
+
+    return query;
+}
+
+const HasRelationship *Model::relationship() const
+{
+    Q_D(const Model);
+    return &d->relationship;
 }
 
 void Model::dump()
@@ -2,6 +2,8 @@
 #define MODEL_H
 
 #include "HasRelationship.h"
+#include "Collection.h"
+#include "ModelMeta.h"
 #include "relations/Relation.h"
 
 #include <QObject>
@@ -41,9 +43,9 @@
  *
  *      // other data
  *
- *      // relationship
+ *      // relationship, invokable to be eager loaded by name: User().with({"posts"}).get()
  *      // for get Post results to call Relation::results() it returns a Collection<Post>
- *      Relation posts() const
+ *      Q_INVOKABLE Relation posts() const
  *      {
  *          // Post derive Model.
  *          // just create a relation query. for get the data from database
@@ -78,6 +80,8 @@
 
 class EloquentBuilder;
 class Connection;
+class QSqlRecord;
+class QSqlQuery;
 class ModelPrivate;
 class Model : public QObject//, public HasRelationship
 {
@@ -94,7 +98,8 @@ public:
 
     static void all(); // return a Collection<Model>
     static void destroy(const QList<int> &ids);
-    static void with();
+    // a query of the model eager loading the relations, nested by dots: "album.artist"
+    EloquentBuilder with(const QStringList &relations) const;
     static void query();
     static void on();
 
@@ -111,7 +116,16 @@ public:
     //! the default foreign key name for the model. default is <classname>_id
     QString foreignKey() const;
 
+    // insert a new model, or update the dirty columns of an existing one
     virtual bool save();
+    /**
+     * save the models in one transaction of their connection: the new ones
+     * in multi-row inserts of the same table and columns, their ids filled
+     * in, then the dirty columns of the existing ones.
+     */
+    static bool saveMany(const Collection &models);
+    // insert the new models as saveMany(), fails for a model that exists
+    static bool insertMany(const Collection &models);
     virtual bool update(const QVariantMap &attributes);
     virtual bool del();
 
@@ -127,6 +141,38 @@ public:
     virtual void setAttribute(const QString &key, const QVariant &value);
     QJsonObject attributesToJson() const;
 
+    /**
+     * the columns changed since the model was read or saved, the property
+     * values included. A NULL column stays NULL until its property is set
+     * to another value, setAttribute() sets any value. Those of a new model
+     * are its attributes and the properties differing from a fresh instance.
+     */
+    bool isDirty(const QString &key = {}) const;
+    QVariantMap getDirty() const;
+    // the attributes as read or saved last
+    QVariantMap original() const;
+    // take the current values as the original ones
+    void syncOriginal();
+
+    // set the attributes read from the database, the model exists then
+    void setRawAttributes(const QVariantMap &attributes, bool sync = true);
+    bool exists() const;
+
+    // a new model of the same class and connection, not owned by anyone
+    Model *newInstance(const QVariantMap &attributes = {}) const;
+    Model *newInstance(const QSqlRecord &record) const;
+    // hydrate the current row of query, map is ModelMeta::map() of its record
+    Model *newInstance(const QSqlQuery &query, const ModelMeta::RecordMap &map) const;
+    // the cached properties of the class
+    const ModelMeta *meta() const;
+
+    // the relation defined by the invokable method name of the model
+    Relation relationNamed(const QString &name) const;
+    // the eager loaded models of relation name, one at most for has-one/belongs-to
+    Collection relation(const QString &name) const;
+    void setRelation(const QString &name, const QList<QSharedPointer<Model> > &models);
+    bool relationLoaded(const QString &name) const;
+
     // TODO: ModelProperty instead of QMetaProperty
     // metaobject properties mapping to model attributes
     // Model:key - MetaProperty => table: column - Field
@@ -177,6 +223,34 @@ public:
 
     void dump();
 
+protected:
+    const HasRelationship *relationship() const;
+
+    template<typename T>
+    Relation hasOne(const QString &foreignKey = {}, const QString localKey = {}) const
+    {
+        return relationship()->template hasOne<T>(foreignKey, localKey);
+    }
+
+    template<typename T>
+    Relation hasMany(const QString &foreignKey = {}, const QString localKey = {}) const
+    {
+        return relationship()->template hasMany<T>(foreignKey, localKey);
+    }
+
+    template<typename T>
+    Relation belongsTo(const QString &foreignKey = {}, const QString ownerKey = {}) const
+    {
+        return relationship()->template belongsTo<T>(foreignKey, ownerKey);
+    }
+
+    template<typename T>
+    Relation belongsToMany(const QString &table = {}, const QString &foreignPivotKey = {},
+                           const QString &relatedPivotKey = {}) const
+    {
+        return relationship()->template belongsToMany<T>(table, foreignPivotKey, relatedPivotKey);
+    }
+
 private:
     // only one copy always while Model convert to eg:User Objects
     QExplicitlySharedDataPointer<ModelPrivate> d_ptr;
@@ -0,0 +1,149 @@
+#include "ModelMeta.h"
+
+#include <QMetaMethod>
+#include <QReadWriteLock>
+#include <QScopedPointer>
+#include <QSqlRecord>
+#include <QVariant>
+
+struct ModelMetaCache
+{
+    QReadWriteLock lock;
+    QHash<const QMetaObject *, ModelMeta *> metas;
+
+    ~ModelMetaCache() { qDeleteAll(metas); }
+};
+
+Q_GLOBAL_STATIC(ModelMetaCache, g_metas)
+
+ModelMeta::ModelMeta(const QMetaObject *meta)
+    : m_meta(meta)
+{
+    // skip properties in the class's superclasses
+    const int offset = meta->propertyOffset();
+    const int count = meta->propertyCount();
+    m_properties.reserve(count - offset);
+
+    for(int i = offset; i < count; ++i)
+    {
+        Property property;
+        property.property = meta->property(i);
+        property.name = QString::fromLatin1(property.property.name());
+        property.index = i;
+        property.type = property.property.userType();
+
+        for(int m = 0; m < meta->methodCount(); ++m)
+        {
+            QString name = QString::fromLatin1(meta->method(m).name());
+            if(name.toLower().endsWith(property.name))
+            {
+                property.slot = name;
+                break;
+            }
+        }
+
+        m_columns.insert(property.name, m_properties.size());
+        m_properties.append(property);
+    }
+
+    const QByteArray className = meta->className();
+    m_constructor = meta->indexOfConstructor(className + "(QObject*)");
+    m_withParent = m_constructor >= 0;
+    if(!m_withParent)
+        m_constructor = meta->indexOfConstructor(className + "()");
+}
+
+const ModelMeta *ModelMeta::of(const QMetaObject *meta)
+{
+    ModelMetaCache *cache = g_metas();
+    {
+        QReadLocker locker(&cache->lock);
+        ModelMeta *result = cache->metas.value(meta);
+        if(result)
+            return result;
+    }
+
+    QWriteLocker locker(&cache->lock);
+    ModelMeta *&result = cache->metas[meta];
+    if(!result)
+        result = new ModelMeta(meta);
+
+    return result;
+}
+
+ModelMeta::RecordMap ModelMeta::map(const QSqlRecord &record) const
+{
+    RecordMap map;
+    map.fields.reserve(record.count());
+    map.properties.reserve(record.count());
+    for(int i = 0; i < record.count(); ++i)
+    {
+        map.fields.append(record.fieldName(i));
+        map.properties.append(this->indexOf(map.fields.last()));
+    }
+
+    return map;
+}
+
+QObject *ModelMeta::create() const
+{
+    if(m_constructor < 0)
+        return nullptr;
+
+    // what QMetaObject::newInstance() does, without the signature lookup
+    QObject *object = nullptr;
+    QObject *parent = nullptr;
+    void *param[] = { &object, &parent };
+    if(m_meta->static_metacall(QMetaObject::CreateInstance, m_constructor, param) >= 0)
+        return nullptr;
+
+    return object;
+}
+
+const QVariantMap &ModelMeta::defaults() const
+{
+    if(m_hasDefaults.loadAcquire())
+        return m_defaults;
+
+    QMutexLocker locker(&m_defaultsMutex);
+    if(m_hasDefaults.load())
+        return m_defaults;
+
+    QScopedPointer<QObject> object(this->create());
+    for(const auto &property : m_properties)
+    {
+        // the default value of the type without an invokable constructor
+        m_defaults.insert(property.name, object ? property.property.read(object.data())
+                                                : QVariant(property.type, nullptr));
+    }
+    m_hasDefaults.storeRelease(1);
+
+    return m_defaults;
+}
+
+bool ModelMeta::write(QObject *object, int position, const QVariant &value, QVariant *written) const
+{
+    const Property &property = m_properties.at(position);
+
+    QVariant typed = value;
+    if(typed.userType() != property.type && property.type != QMetaType::QVariant)
+    {
+        // NULL resets the property to the default value of its type
+        if(typed.isNull())
+            typed = QVariant(property.type, nullptr);
+        else if(!typed.convert(property.type))
+            return false;
+    }
+
+    // what QMetaProperty::write() ends up in, without its lookups
+    int status = -1;
+    int flags = 0;
+    void *argv[] = { property.type == QMetaType::QVariant ? static_cast<void *>(&typed) : typed.data(),
+                     &typed, &status, &flags };
+    QMetaObject::metacall(object, QMetaObject::WriteProperty, property.index, argv);
+
+    if(written)
+        *written = typed;
+
+    return true;
+}
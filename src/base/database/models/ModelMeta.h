@@ -0,0 +1,78 @@
+#ifndef MODELMETA_H
+#define MODELMETA_H
+
+#include <QMetaProperty>
+#include <QVector>
+#include <QHash>
+#include <QVariantMap>
+#include <QMutex>
+#include <QAtomicInt>
+
+class QSqlRecord;
+
+/**
+ * @brief The ModelMeta class
+ * the properties of a model class, built once per QMetaObject and shared
+ * by all of its models. Columns are mapped to properties by name.
+ */
+class ModelMeta
+{
+public:
+    struct Property
+    {
+        QMetaProperty property;
+        QString name;
+        QString slot; // the setter found by name, for dumping only
+        int index = -1; // the absolute property index
+        int type = QMetaType::UnknownType;
+    };
+
+    // the columns of a result layout, -1 for a column without property
+    struct RecordMap
+    {
+        QStringList fields;
+        QVector<int> properties;
+    };
+
+    static const ModelMeta *of(const QMetaObject *meta);
+
+    const QMetaObject *metaObject() const { return m_meta; }
+    // the properties declared by the class itself, not by its superclasses
+    const QVector<Property> &properties() const { return m_properties; }
+    // position in properties() of the column, -1 if there is none
+    int indexOf(const QString &column) const { return m_columns.value(column, -1); }
+
+    RecordMap map(const QSqlRecord &record) const;
+
+    // a new object by the invokable constructor, nullptr if there is none
+    QObject *create() const;
+
+    /**
+     * the property values of a new object, by name, made once. The columns
+     * of a new model still at these values are left to the database defaults.
+     */
+    const QVariantMap &defaults() const;
+
+    /**
+     * write the value converted to the type of the property at position,
+     * written receives what the property holds then. false if it can not be
+     * converted, the property is left alone.
+     */
+    bool write(QObject *object, int position, const QVariant &value, QVariant *written = nullptr) const;
+
+private:
+    explicit ModelMeta(const QMetaObject *meta);
+
+    const QMetaObject *m_meta = nullptr;
+    QVector<Property> m_properties;
+    QHash<QString, int> m_columns;
+    int m_constructor = -1;
+    bool m_withParent = false; // the constructor takes the parent
+
+    // every save() of a new model reads them, the lock is only taken to make them
+    mutable QMutex m_defaultsMutex;
+    mutable QVariantMap m_defaults;
+    mutable QAtomicInt m_hasDefaults = 0;
+};
+
+#endif // MODELMETA_H
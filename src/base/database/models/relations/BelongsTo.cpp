@@ -1,6 +1,46 @@
 #include "BelongsTo.h"
+#include "Relation_p.h"
+#include "../Model.h"
+#include "query/QueryBuilder.h"
 
-BelongsTo::BelongsTo()
+class BelongsToPrivate : public RelationPrivate
 {
+public:
+    BelongsToPrivate(Relation *q) : RelationPrivate(q) { }
 
+    QVariantList eagerKeys(const QList<Model *> &models) const override
+    {
+        return collectKeys(models, foreignKey);
+    }
+
+    void addEagerConstraints(QueryBuilder &query, const QVariantList &keys) const override
+    {
+        query.whereIn(ownerKey, keys);
+    }
+
+    void match(const QString &name, const QList<Model *> &models,
+               const QList<QSharedPointer<Model> > &results) const override
+    {
+        // the owners are shared by all of their children
+        QHash<QString, QSharedPointer<Model> > dictionary;
+        foreach (auto &result, results)
+            dictionary.insert(result->attribute(ownerKey).toString(), result);
+
+        foreach (auto model, models)
+        {
+            QSharedPointer<Model> owner = dictionary.value(model->attribute(foreignKey).toString());
+            model->setRelation(name, owner ? QList<QSharedPointer<Model> >{owner} : QList<QSharedPointer<Model> >());
+        }
+    }
+
+    QString foreignKey;
+    QString ownerKey;
+};
+
+BelongsTo::BelongsTo(Model *related, Model *child, const QString &foreignKey, const QString &ownerKey)
+    : Relation(*new BelongsToPrivate(this), related, child)
+{
+    Q_D(BelongsTo);
+    d->foreignKey = foreignKey;
+    d->ownerKey = ownerKey;
 }
@@ -3,10 +3,16 @@
 
 #include "Relation.h"
 
+/**
+ * @brief The BelongsTo class
+ * the child model holds foreignKey referencing ownerKey of the related model
+ */
+class BelongsToPrivate;
 class BelongsTo : public Relation
 {
+    Q_DECLARE_PRIVATE(BelongsTo)
 public:
-    BelongsTo();
+    BelongsTo(Model *related, Model *child, const QString &foreignKey, const QString &ownerKey);
 };
 
 #endif // BELONGSTO_H
@@ -1,6 +1,63 @@
 #include "BelongsToMany.h"
+#include "Relation_p.h"
+#include "../Model.h"
+#include "query/QueryBuilder.h"
 
-BelongsToMany::BelongsToMany()
+// the parent key of a related row, selected from the pivot table
+static const QString PivotParentKey = "pivot_parent_key";
+
+class BelongsToManyPrivate : public RelationPrivate
+{
+public:
+    BelongsToManyPrivate(Relation *q) : RelationPrivate(q) { }
+
+    QVariantList eagerKeys(const QList<Model *> &models) const override
+    {
+        return collectKeys(models, parentKey);
+    }
+
+    void addEagerConstraints(QueryBuilder &query, const QVariantList &keys) const override
+    {
+        const QString relatedTable = related->table();
+        query.select(QStringList{relatedTable + ".*",
+                                 table + "." + foreignPivotKey + " as " + PivotParentKey});
+        query.join(table, table + "." + relatedPivotKey, "=", relatedTable + "." + relatedKey);
+        query.whereIn(table + "." + foreignPivotKey, keys);
+    }
+
+    void match(const QString &name, const QList<Model *> &models,
+               const QList<QSharedPointer<Model> > &results) const override
+    {
+        QHash<QString, QList<QSharedPointer<Model> > > dictionary;
+        foreach (auto &result, results)
+            dictionary[result->attribute(PivotParentKey).toString()].append(result);
+
+        foreach (auto model, models)
+            model->setRelation(name, dictionary.value(model->attribute(parentKey).toString()));
+    }
+
+    QString table;
+    QString foreignPivotKey;
+    QString relatedPivotKey;
+    QString parentKey;
+    QString relatedKey;
+};
+
+BelongsToMany::BelongsToMany(Model *related, Model *parent, const QString &table,
+                             const QString &foreignPivotKey, const QString &relatedPivotKey,
+                             const QString &parentKey, const QString &relatedKey)
+    : Relation(*new BelongsToManyPrivate(this), related, parent)
 {
+    Q_D(BelongsToMany);
+    d->table = table;
+    d->foreignPivotKey = foreignPivotKey;
+    d->relatedPivotKey = relatedPivotKey;
+    d->parentKey = parentKey;
+    d->relatedKey = relatedKey;
+}
 
+QString BelongsToMany::table() const
+{
+    Q_D(const BelongsToMany);
+    return d->table;
 }
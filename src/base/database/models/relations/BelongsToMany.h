@@ -3,10 +3,20 @@
 
 #include "Relation.h"
 
+/**
+ * @brief The BelongsToMany class
+ * parent and related models are linked by the rows of the pivot table
+ */
+class BelongsToManyPrivate;
 class BelongsToMany : public Relation
 {
+    Q_DECLARE_PRIVATE(BelongsToMany)
 public:
-    BelongsToMany();
+    BelongsToMany(Model *related, Model *parent, const QString &table,
+                  const QString &foreignPivotKey, const QString &relatedPivotKey,
+                  const QString &parentKey, const QString &relatedKey);
+
+    QString table() const;
 };
 
 #endif // BELONGSTOMANY_H
@@ -1,7 +1,8 @@
 #include "HasOne.h"
+#include "HasOneOrMany_p.h"
 
 HasOne::HasOne(Model *related, Model *parent, const QString &foreignKey, const QString &localKey)
     : HasOneOrMany(related, parent, foreignKey, localKey)
 {
-
+    static_cast<HasOneOrManyPrivate *>(d_ptr.data())->many = false;
 }
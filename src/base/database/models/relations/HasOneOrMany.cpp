@@ -1,5 +1,7 @@
 #include "HasOneOrMany.h"
 #include "HasOneOrMany_p.h"
+#include "../Model.h"
+#include "query/QueryBuilder.h"
 
 HasOneOrManyPrivate::HasOneOrManyPrivate(Relation *q)
     : RelationPrivate(q)
@@ -7,6 +9,33 @@ HasOneOrManyPrivate::HasOneOrManyPrivate(Relation *q)
 
 }
 
+QVariantList HasOneOrManyPrivate::eagerKeys(const QList<Model *> &models) const
+{
+    return collectKeys(models, localKey);
+}
+
+void HasOneOrManyPrivate::addEagerConstraints(QueryBuilder &query, const QVariantList &keys) const
+{
+    query.whereIn(foreignKey, keys);
+}
+
+void HasOneOrManyPrivate::match(const QString &name, const QList<Model *> &models,
+                                const QList<QSharedPointer<Model> > &results) const
+{
+    // children by the key of their parent
+    QHash<QString, QList<QSharedPointer<Model> > > dictionary;
+    foreach (auto &result, results)
+        dictionary[result->attribute(foreignKey).toString()].append(result);
+
+    foreach (auto model, models)
+    {
+        QList<QSharedPointer<Model> > children = dictionary.value(model->attribute(localKey).toString());
+        if(!many && children.size() > 1)
+            children = children.mid(0, 1);
+        model->setRelation(name, children);
+    }
+}
+
 HasOneOrMany::HasOneOrMany(Model *related, Model *parent, const QString &foreignKey, const QString &localKey)
     : Relation(*new HasOneOrManyPrivate(this), related, parent)
 {
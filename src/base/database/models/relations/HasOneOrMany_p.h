@@ -8,8 +8,14 @@ class HasOneOrManyPrivate : public RelationPrivate
 public:
     HasOneOrManyPrivate(Relation *q);
 
+    QVariantList eagerKeys(const QList<Model *> &models) const override;
+    void addEagerConstraints(QueryBuilder &query, const QVariantList &keys) const override;
+    void match(const QString &name, const QList<Model *> &models,
+               const QList<QSharedPointer<Model> > &results) const override;
+
     QString foreignKey;
     QString localKey;
+    bool many = true;
 };
 
 #endif // HASONEORMANY_P_H
@@ -1,6 +1,15 @@
 #include "Relation.h"
 #include "Relation_p.h"
 #include "../Model.h"
+#include "Connection.h"
+#include "QueryProfiler.h"
+#include "query/QueryBuilder.h"
+#include "query/QueryGrammar.h"
+
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QSet>
+#include <QDebug>
 
 RelationPrivate::RelationPrivate(Relation *q) : q_ptr(q)
 {
@@ -9,7 +18,44 @@ RelationPrivate::RelationPrivate(Relation *q) : q_ptr(q)
 
 RelationPrivate::~RelationPrivate()
 {
+    delete related;
+}
 
+QVariantList RelationPrivate::eagerKeys(const QList<Model *> &models) const
+{
+    Q_UNUSED(models)
+    return QVariantList();
+}
+
+void RelationPrivate::addEagerConstraints(QueryBuilder &query, const QVariantList &keys) const
+{
+    Q_UNUSED(query)
+    Q_UNUSED(keys)
+}
+
+void RelationPrivate::match(const QString &name, const QList<Model *> &models,
+                            const QList<QSharedPointer<Model> > &results) const
+{
+    Q_UNUSED(results)
+    foreach (auto model, models)
+        model->setRelation(name, {});
+}
+
+QVariantList RelationPrivate::collectKeys(const QList<Model *> &models, const QString &key)
+{
+    QVariantList keys;
+    QSet<QString> seen;
+    foreach (auto model, models)
+    {
+        QVariant value = model->attribute(key);
+        if(value.isNull() || seen.contains(value.toString()))
+            continue;
+
+        seen.insert(value.toString());
+        keys.append(value);
+    }
+
+    return keys;
 }
 
 Relation::Relation() {}
@@ -27,13 +73,15 @@ Relation::Relation(Model *related, Model *parent)
 }
 
 Relation::Relation(const Relation &other)
+    : d_ptr(other.d_ptr)
 {
-    d_ptr.reset(other.d_ptr.get());
+
 }
 
 Relation::Relation(const Relation &&other)
+    : d_ptr(other.d_ptr)
 {
-    d_ptr.reset(other.d_ptr.get());
+
 }
 
 Relation::Relation(RelationPrivate &dd, EloquentBuilder *builder, Model *parent)
@@ -58,18 +106,35 @@ Relation::~Relation()
 
 Relation &Relation::operator=(const Relation &other)
 {
-    d_ptr.reset(other.d_ptr.get());
+    d_ptr = other.d_ptr;
     return *this;
 }
 
 bool Relation::operator==(const Relation &other)
 {
     // TODO: compare primary key and connection
+    if(!d_ptr || !other.d_ptr)
+        return d_ptr == other.d_ptr;
 
     return d_ptr->related == other.d_ptr->related
             && d_ptr->parent == other.d_ptr->parent;
 }
 
+bool Relation::isValid() const
+{
+    return d_ptr && d_ptr->related;
+}
+
+Model *Relation::related() const
+{
+    return d_ptr ? d_ptr->related : nullptr;
+}
+
+Model *Relation::parent() const
+{
+    return d_ptr ? d_ptr->parent : nullptr;
+}
+
 void Relation::createConstraints()
 {
     // Set the base constraints on the relation query
@@ -89,3 +154,47 @@ void Relation::touch()
 {
 
 }
+
+bool Relation::eagerLoad(const QString &name, const QList<Model *> &models) const
+{
+    Q_D(const Relation);
+    if(!this->isValid() || models.isEmpty())
+        return false;
+
+    Connection *connection = d->related->connection();
+    if(!connection)
+    {
+        qWarning() << "No connection to load the relation:" << name;
+        return false;
+    }
+
+    QueryGrammar *grammar = qobject_cast<QueryGrammar *>(connection->queryGrammar().data());
+    const int size = grammar ? grammar->maxBindings() : 999;
+
+    QVariantList keys = d->eagerKeys(models);
+    QList<QSharedPointer<Model> > results;
+    for(int i = 0; i < keys.size(); i += size)
+    {
+        QueryBuilder query(connection);
+        query.from(d->related->table());
+        d->addEagerConstraints(query, keys.mid(i, size));
+
+        QSqlQuery result = query.cursor();
+        if(!result.isActive())
+            return false;
+
+        ModelMeta::RecordMap map = d->related->meta()->map(result.record());
+        const int read = results.size();
+        while(result.next())
+        {
+            Model *model = d->related->newInstance(result, map);
+            if(model)
+                results.append(QSharedPointer<Model>(model));
+        }
+        QueryProfiler::instance()->consumed(result, results.size() - read);
+    }
+
+    d->match(name, models, results);
+
+    return true;
+}
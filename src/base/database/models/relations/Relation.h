@@ -3,11 +3,23 @@
 
 //#include "eloquent/EloquentBuilder.h"
 #include <QObject>
+#include <QSharedPointer>
+#include <QVariant>
 
 class Model;
 class EloquentBuilder;
+class QueryBuilder;
 class RelationPrivate;
 
+/**
+ * @brief The Relation class
+ * copies share the same relation, HasOne/HasMany/BelongsTo/... returned as
+ * a Relation keep their behaviour in the private.
+ *
+ * a relation is eager loaded by its name, so the method defining it in the
+ * model has to be Q_INVOKABLE:
+ *      Q_INVOKABLE Relation album() const { return belongsTo<Album>(); }
+ */
 // TODO: derive EloquentBuilder for call where/find/first ...
 class Relation //: public EloquentBuilder
 {
@@ -23,6 +35,10 @@ public:
     Relation &operator=(const Relation &other);
     bool operator==(const Relation &other);
 
+    bool isValid() const;
+    Model *related() const;
+    Model *parent() const;
+
     virtual void createConstraints();
     virtual QVariant results() const;
 
@@ -31,10 +47,18 @@ public:
 
     virtual void touch();
 
+    /**
+     * load the related models of all models with one "where in" query per
+     * chunk of keys and set them as relation name of their parents.
+     */
+    bool eagerLoad(const QString &name, const QList<Model *> &models) const;
+
 protected:
     Relation(RelationPrivate &dd, EloquentBuilder *builder, Model *parent);
     Relation(RelationPrivate &dd, Model *related, Model *parent);
-    QScopedPointer<RelationPrivate> d_ptr;
+    QSharedPointer<RelationPrivate> d_ptr;
 };
 
+Q_DECLARE_METATYPE(Relation)
+
 #endif // RELATION_H
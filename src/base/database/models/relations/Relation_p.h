@@ -2,8 +2,11 @@
 #define RELATION_P_H
 
 #include <QObject>
+#include <QSharedPointer>
+#include <QVariant>
 
 class EloquentBuilder;
+class QueryBuilder;
 class Relation;
 class Model;
 
@@ -14,10 +17,21 @@ public:
     explicit RelationPrivate(Relation *q);
     virtual ~RelationPrivate();
 
+    // the distinct keys of the models the related ones are looked up by
+    virtual QVariantList eagerKeys(const QList<Model *> &models) const;
+    // constrain query to the related models of keys
+    virtual void addEagerConstraints(QueryBuilder &query, const QVariantList &keys) const;
+    // set the related models as relation name of their parents
+    virtual void match(const QString &name, const QList<Model *> &models,
+                       const QList<QSharedPointer<Model> > &results) const;
+
+    // the distinct, non null values of key of models
+    static QVariantList collectKeys(const QList<Model *> &models, const QString &key);
+
     Relation *q_ptr = nullptr;
 
     EloquentBuilder *query = nullptr;
-    Model *related = nullptr;
+    Model *related = nullptr; // owned by the relation
     Model *parent = nullptr;
 };
 
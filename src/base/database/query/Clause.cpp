@@ -1,6 +1,7 @@
 #include "Clause.h"
 #include "QueryBuilder.h"
 #include "QueryGrammar.h"
+#include "ClauseArena.h"
 
 #include <QSharedData>
 #include <QMetaMethod>
@@ -46,6 +47,9 @@ public:
     ClausePrivate(const ClausePrivate &other) : QSharedData(other) { }
     virtual ~ClausePrivate() {}
 
+    static void *operator new(size_t size) { return ClauseArena::create(size); }
+    static void operator delete(void *pointer) { ClauseArena::destroy(pointer); }
+
 public:
     QueryBuilder *parent = nullptr;
     QStringList columns;
@@ -93,7 +97,6 @@ public:
 //    QString first;
 //    QString second;
     QVariant value;
-    bool isLeading = false;
     QSharedPointer<QueryBuilder> subQuery;
 };
 
@@ -106,7 +109,6 @@ public:
     QString op;
     bool betweenOrNot = true; // default is between
     bool _between = false;
-    bool isLeading = false;
 };
 
 class GroupClausePrivate : public ClausePrivate
@@ -119,7 +121,6 @@ class OrderClausePrivate : public ClausePrivate
 {
 public:
     QString direction;
-    bool isLeading = false;
 };
 
 class UnionClausePrivate : public ClausePrivate
@@ -159,7 +160,16 @@ Clause::Clause(ClausePrivate &dd, QueryBuilder *parent)
 
 Clause::~Clause()
 {
-    qDebug() << "Clause::~Clause()";
+}
+
+void *Clause::operator new(size_t size)
+{
+    return ClauseArena::create(size);
+}
+
+void Clause::operator delete(void *pointer)
+{
+    ClauseArena::destroy(pointer);
 }
 
 void Clause::setColumns(const QString &columns)
@@ -515,9 +525,7 @@ WhereClause::WhereClause(const QString &column, const QVariant &value,
 
 QString WhereClause::interpret(QueryGrammar *grammar, bool leading)
 {
-    Q_D(WhereClause);
-    d->isLeading = leading;
-    return grammar->clauseWhere(this);
+    return grammar->clauseWhere(this, leading);
 }
 
 void WhereClause::setParentQuery(QueryBuilder *parent)
@@ -538,12 +546,6 @@ int WhereClause::type() const
     return d->type;
 }
 
-bool WhereClause::leading() const
-{
-    Q_D(const WhereClause);
-    return d->isLeading;
-}
-
 QVariant WhereClause::value() const
 {
     Q_D(const WhereClause);
@@ -613,15 +615,13 @@ HavingClause::HavingClause(const QString &column, const QVariant &value,
 QString HavingClause::interpret(QueryGrammar *grammar, bool leading)
 {
     Q_D(HavingClause);
-    d->isLeading = leading;
-
     if(d->_between)
     {
-         return grammar->clauseHavingBetween(this);
+         return grammar->clauseHavingBetween(this, leading);
     }
     else
     {
-        return grammar->clauseHaving(this);
+        return grammar->clauseHaving(this, leading);
     }
 }
 
@@ -649,12 +649,6 @@ bool HavingClause::betweenOrNot() const
     return d->betweenOrNot;
 }
 
-bool HavingClause::leading() const
-{
-    Q_D(const HavingClause);
-    return d->isLeading;
-}
-
 /**
  * @brief GroupClause::GroupClause
  * @param columns
@@ -700,9 +694,7 @@ OrderClause::OrderClause(const QStringList &columns, const QString &direction)
 
 QString OrderClause::interpret(QueryGrammar *grammar, bool leading)
 {
-    Q_D(OrderClause);
-    d->isLeading = leading;
-    return grammar->clauseOrder(this);
+    return grammar->clauseOrder(this, leading);
 }
 
 QString OrderClause::direction() const
@@ -711,12 +703,6 @@ QString OrderClause::direction() const
     return d->direction;
 }
 
-bool OrderClause::leading() const
-{
-    Q_D(const OrderClause);
-    return d->isLeading;
-}
-
 /**
  * @brief UnionClause::UnionClause
  * @param query
@@ -4,6 +4,8 @@
 #include <QObject>
 #include <QVariant>
 #include <QExplicitlySharedDataPointer>
+#include <QAtomicInt>
+#include <QSharedPointer>
 
 class QueryBuilder;
 class QueryGrammar;
@@ -31,6 +33,10 @@ public:
     explicit Clause(QueryBuilder *parent = nullptr);
     virtual ~Clause();
 
+    // placed in the current ClauseArena when there is one
+    static void *operator new(size_t size);
+    static void operator delete(void *pointer);
+
     virtual QString interpret(QueryGrammar *grammar, bool leading = false) = 0;
 
     void setColumns(const QString &columns);
@@ -41,7 +47,38 @@ public:
 protected:
     Clause(ClausePrivate &dd, QueryBuilder *parent = nullptr);
     QExplicitlySharedDataPointer<ClausePrivate> d_ptr; // only one ref instance of
+
+private:
+    friend class ClausePointer;
+    QAtomicInt ref; // the ClausePointers sharing this clause
+};
+
+/**
+ * @brief The ClausePointer class
+ * a shared clause, counted in the clause itself. Clauses are not changed
+ * once added, interpret() gets whether it leads its kind as a parameter,
+ * so the copies of a builder share them, across threads too.
+ */
+class ClausePointer
+{
+public:
+    ClausePointer() = default;
+    explicit ClausePointer(Clause *clause) : d(clause) { if(d) d->ref.ref(); }
+    ClausePointer(const ClausePointer &other) : d(other.d) { if(d) d->ref.ref(); }
+    ClausePointer(ClausePointer &&other) noexcept : d(other.d) { other.d = nullptr; }
+    ~ClausePointer() { if(d && !d->ref.deref()) delete d; }
+
+    ClausePointer &operator=(ClausePointer other) { qSwap(d, other.d); return *this; }
+
+    Clause *data() const { return d; }
+    Clause *operator->() const { return d; }
+    Clause &operator*() const { return *d; }
+    bool isNull() const { return !d; }
+
+private:
+    Clause *d = nullptr;
 };
+typedef QList<ClausePointer> ClauseList;
 
 class FromClausePrivate;
 class FromClause : public Clause
@@ -218,7 +255,6 @@ public:
     QString whereMethod() const;
 
     int type() const;
-    bool leading() const;
     QVariant value() const;
     QString op() const ;
     QString boolean();
@@ -245,7 +281,6 @@ public:
     QString boolean() const;
     QString op() const;
     bool betweenOrNot() const;
-    bool leading() const;
 };
 
 class GroupClausePrivate;
@@ -269,7 +304,6 @@ public:
 
     QString interpret(QueryGrammar *grammar, bool leading) override;
     QString direction() const;
-    bool leading() const;
 };
 
 class UnionClausePrivate;
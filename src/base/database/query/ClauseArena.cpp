@@ -0,0 +1,160 @@
+#include "ClauseArena.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace  {
+    const size_t Alignment = alignof(std::max_align_t);
+
+    // every allocation is preceded by a header telling where it came from
+    struct alignas(std::max_align_t) Header
+    {
+        ClauseArena *arena;
+        size_t size;
+    };
+
+    size_t aligned(size_t size)
+    {
+        return (size + Alignment - 1) & ~(Alignment - 1);
+    }
+
+    thread_local ClauseArena *g_currentArena = nullptr;
+}
+
+ClauseArena::ClauseArena(int blockSize)
+    : blockSize(aligned(size_t(qMax(blockSize, 256))))
+{
+
+}
+
+ClauseArena::~ClauseArena()
+{
+    while(head)
+    {
+        Block *next = head->next;
+        std::free(head);
+        head = next;
+    }
+}
+
+void *ClauseArena::allocate(size_t size)
+{
+    size = aligned(size);
+    QMutexLocker locker(&mutex);
+
+    const size_t list = size / Alignment - 1;
+    if(list < size_t(FreeLists) && freeLists[list])
+    {
+        FreeNode *node = freeLists[list];
+        freeLists[list] = node->next;
+        used += size;
+        return node;
+    }
+
+    if(!head || head->used + size > head->size)
+        grow(size);
+
+    char *data = reinterpret_cast<char *>(head) + aligned(sizeof(Block));
+    void *pointer = data + head->used;
+    head->used += size;
+    used += size;
+
+    return pointer;
+}
+
+void ClauseArena::recycle(void *pointer, size_t size)
+{
+    size = aligned(size);
+    QMutexLocker locker(&mutex);
+    used -= size;
+
+    // an oversized allocation stays where it is until the arena is deleted
+    const size_t list = size / Alignment - 1;
+    if(list >= size_t(FreeLists))
+        return;
+
+    FreeNode *node = static_cast<FreeNode *>(pointer);
+    node->next = freeLists[list];
+    freeLists[list] = node;
+}
+
+int ClauseArena::blockCount() const
+{
+    QMutexLocker locker(&mutex);
+    return blocks;
+}
+
+size_t ClauseArena::bytesUsed() const
+{
+    QMutexLocker locker(&mutex);
+    return used;
+}
+
+ClauseArena::Block *ClauseArena::grow(size_t size)
+{
+    // each block doubles the previous one, an oversized request gets its own
+    size_t capacity = head ? head->size * 2 : blockSize;
+    capacity = qMax(capacity, size);
+
+    void *memory = std::malloc(aligned(sizeof(Block)) + capacity);
+    if(!memory)
+        throw std::bad_alloc();
+
+    Block *block = static_cast<Block *>(memory);
+    block->next = head;
+    block->size = capacity;
+    block->used = 0;
+    head = block;
+    ++blocks;
+
+    return block;
+}
+
+ClauseArena::Scope::Scope(ClauseArena *arena)
+    : previous(g_currentArena)
+{
+    g_currentArena = arena;
+}
+
+ClauseArena::Scope::~Scope()
+{
+    g_currentArena = previous;
+}
+
+ClauseArena *ClauseArena::current()
+{
+    return g_currentArena;
+}
+
+void *ClauseArena::create(size_t size)
+{
+    ClauseArena *arena = g_currentArena;
+    size += sizeof(Header);
+    void *memory = arena ? arena->allocate(size) : ::operator new(size);
+
+    Header *header = static_cast<Header *>(memory);
+    header->arena = arena;
+    header->size = size;
+    if(arena)
+        arena->ref.ref();
+
+    return header + 1;
+}
+
+void ClauseArena::destroy(void *pointer)
+{
+    if(!pointer)
+        return;
+
+    Header *header = static_cast<Header *>(pointer) - 1;
+    ClauseArena *arena = header->arena;
+    if(!arena)
+    {
+        ::operator delete(header);
+        return;
+    }
+
+    arena->recycle(header, header->size);
+    if(!arena->ref.deref())
+        delete arena;
+}
@@ -0,0 +1,84 @@
+#ifndef CLAUSEARENA_H
+#define CLAUSEARENA_H
+
+#include <QtGlobal>
+#include <QSharedData>
+#include <QMutex>
+#include <cstddef>
+
+/**
+ * @brief The ClauseArena class
+ * an allocator for the clauses of a query builder and their privates.
+ * memory is handed out from a few growing blocks, the bytes of a deleted
+ * clause go to a free list of their size and are reused by the next clause
+ * of that size, so a builder replacing its clauses does not grow the arena.
+ *
+ * every allocation holds a reference on its arena, the arena is deleted
+ * with the last of its clauses or owners, whichever goes last.
+ */
+class ClauseArena : public QSharedData
+{
+    Q_DISABLE_COPY(ClauseArena)
+public:
+    // the size of the first block, a typical query fits in it
+    static const int DefaultBlockSize = 4096;
+
+    explicit ClauseArena(int blockSize = DefaultBlockSize);
+    ~ClauseArena();
+
+    void *allocate(size_t size);
+    // the bytes of an allocation of size are free to be reused
+    void recycle(void *pointer, size_t size);
+
+    int blockCount() const;
+    size_t bytesUsed() const;
+
+    /**
+     * clauses and clause privates created on this thread while a scope is
+     * alive are placed in its arena, scopes may nest.
+     */
+    class Scope
+    {
+        Q_DISABLE_COPY(Scope)
+    public:
+        explicit Scope(ClauseArena *arena);
+        ~Scope();
+
+    private:
+        ClauseArena *previous = nullptr;
+    };
+
+    static ClauseArena *current();
+
+    // storage for operator new/delete of Clause and ClausePrivate
+    static void *create(size_t size);
+    static void destroy(void *pointer);
+
+private:
+    struct Block
+    {
+        Block *next;
+        size_t size;
+        size_t used;
+    };
+
+    struct FreeNode
+    {
+        FreeNode *next;
+    };
+
+    // allocations up to this many alignment units are recycled
+    static const int FreeLists = 32;
+
+    Block *grow(size_t size);
+
+    // clauses may be deleted on another thread than the one creating them
+    mutable QMutex mutex;
+    Block *head = nullptr;
+    FreeNode *freeLists[FreeLists] = {};
+    size_t blockSize = 0;
+    int blocks = 0;
+    size_t used = 0;
+};
+
+#endif // CLAUSEARENA_H
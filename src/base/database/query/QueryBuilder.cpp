@@ -1,12 +1,25 @@
 #include "QueryBuilder.h"
-#include "Grammar.h"
+#include "QueryGrammar.h"
+#include "ResultSet.h"
+#include "Bindings.h"
 #include "Clause.h"
+#include "ClauseArena.h"
 #include "Connection.h"
+#include "Database.h"
+#include "QueryExecutor.h"
+#include "QueryProfiler.h"
 
 #include <QMap>
+#include <QSqlRecord>
 #include <QDate>
 #include <QDateTime>
 #include <QLoggingCategory>
+#include <QSharedPointer>
+#include <QAtomicInt>
+
+#include <utility>
+
+static QAtomicInt g_arenaEnabled(1);
 
 static const QStringList ClauseOperators =
 {
@@ -18,6 +31,9 @@ static const QStringList ClauseOperators =
     "not similar to", "not ilike", "~~*", "!~~*",
 };
 
+// the most rows compiled into a single multi-row insert
+static const int MaxInsertChunk = 500;
+
 static bool invalidOperator(const QString &op)
 {
     return !ClauseOperators.contains(op.toLower());
@@ -44,35 +60,69 @@ public:
     {
         Q_Q(QueryBuilder);
         isAggregated = true;
-        AggregateClause *agg = new AggregateClause(q, funciton, columns);
-        clauses[Clause::Aggregate] = {agg};
+        AggregateClause *agg = make<AggregateClause>(q, funciton, columns);
+        setClause(Clause::Aggregate, agg);
 
-        if(clauses[Clause::GroupBy].isEmpty())
+        if(clauses.value(Clause::GroupBy).isEmpty())
         {
             removeClause(Clause::Order);
             removeBindings(QueryBuilder::OrderBinding);
         }
     }
 
+    // a copy shares the clause lists, either side copies a list when it changes it
+    void assign(const QueryBuilderPrivate &other)
+    {
+        connection = other.connection;
+        grammar = other.grammar;
+        table = other.table;
+        isDistincted = other.isDistincted;
+        isAggregated = other.isAggregated;
+        clauses = other.clauses;
+        bindings = other.bindings;
+    }
+
+    // clauses are placed in the arena of the builder, created on first use
+    template<typename T, typename... Args>
+    T *make(Args&&... args)
+    {
+        ClauseArena *target = nullptr;
+        if(g_arenaEnabled.load())
+        {
+            if(!arena)
+                arena.reset(new ClauseArena);
+            target = arena.data();
+        }
+
+        // no arena: from the heap, even inside the scope of another builder
+        ClauseArena::Scope scope(target);
+        return new T(std::forward<Args>(args)...);
+    }
+
+    // an arena clause keeps its arena alive, copies may outlive the builder
+    ClausePointer adopt(Clause *clause) const
+    {
+        return ClausePointer(clause);
+    }
+
     void removeClause(Clause::ClauseType type)
     {
-        qDeleteAll(clauses[type]);
         clauses.remove(type);
     }
 
     void setClause(Clause::ClauseType type, Clause *clause)
     {
-        clauses[type] = {clause};
+        clauses.insert(type, {adopt(clause)});
     }
 
-    void setClause(Clause::ClauseType type, const QList<Clause*> &list)
+    void setClause(Clause::ClauseType type, const ClauseList &list)
     {
-        clauses[type] = list;
+        clauses.insert(type, list);
     }
 
     void addClause(Clause::ClauseType type, Clause *clause)
     {
-        clauses[type].append(clause);
+        clauses[type].append(adopt(clause));
     }
 
     bool hasClause(Clause::ClauseType type) const
@@ -95,7 +145,7 @@ public:
 
         if(!query.clauses(Clause::Where).isEmpty())
         {
-            this->addClause(Clause::Where, new WhereClause(WhereClause::Nested, query, boolean));
+            this->addClause(Clause::Where, make<WhereClause>(WhereClause::Nested, query, boolean));
         }
 
         return q;
@@ -111,11 +161,185 @@ public:
         query.from(table);
         select(query);
 
-        this->addClause(Clause::Where, new WhereClause(WhereClause::Sub, column, op, query, boolean));
+        this->addClause(Clause::Where, make<WhereClause>(WhereClause::Sub, column, op, query, boolean));
 
         return q_ptr;
     }
 
+    // rows in the order of columns, missing values are null
+    QList<QVariantMap> normalize(const QList<QVariantMap> &records, const QStringList &columns) const
+    {
+        QList<QVariantMap> rows;
+        rows.reserve(records.size());
+        foreach (auto &record, records)
+        {
+            if(record.size() == columns.size() && record.keys() == columns)
+            {
+                rows.append(record);
+                continue;
+            }
+
+            QVariantMap row;
+            foreach (auto &column, columns)
+                row.insert(column, record.value(column));
+            rows.append(row);
+        }
+
+        return rows;
+    }
+
+    /**
+     * which row of a multi-row insert the driver reports the id of: SQLite
+     * the last one, MySQL (LAST_INSERT_ID) the first one. Generated ids of a
+     * single statement are consecutive for both, other drivers can not tell.
+     */
+    enum InsertedId { UnknownId, LastId, FirstId };
+
+    InsertedId insertedId() const
+    {
+        const QString driver = connection->driverName();
+        if(driver.compare("QSQLITE", Qt::CaseInsensitive) == 0)
+            return LastId;
+        if(driver.compare("QMYSQL", Qt::CaseInsensitive) == 0)
+            return FirstId;
+
+        return UnknownId;
+    }
+
+    // the ids of rows inserted by one statement, id is the one the driver reported
+    void appendIds(const QList<QVariantMap> &rows, const QString &key, const QVariant &id, QVariantList &ids) const
+    {
+        if(rows.size() == 1)
+        {
+            const QVariant value = rows.first().value(key);
+            ids.append(value.isNull() ? id : value);
+            return;
+        }
+
+        const qint64 reported = id.toLongLong();
+        const qint64 first = insertedId() == FirstId ? reported : reported - rows.size() + 1;
+        for(int i = 0; i < rows.size(); ++i)
+        {
+            const QVariant value = rows.at(i).value(key);
+            ids.append(value.isNull() ? QVariant(first + i) : value);
+        }
+    }
+
+    /**
+     * the ids of a multi-row statement are known if its keys are all given,
+     * or all generated by a driver telling which row its id belongs to.
+     * Otherwise the rows are inserted one by one.
+     */
+    bool identifiable(const QList<QVariantMap> &rows, const QString &key) const
+    {
+        if(rows.size() < 2)
+            return true;
+
+        int generated = 0;
+        foreach (auto &row, rows)
+        {
+            if(row.value(key).isNull())
+                ++generated;
+        }
+
+        if(generated == 0)
+            return true;
+
+        return generated == rows.size() && insertedId() != UnknownId;
+    }
+
+    bool insertChunk(const QList<QVariantMap> &rows, const QString &key, QVariantList &ids)
+    {
+        Q_Q(QueryBuilder);
+        if(!identifiable(rows, key))
+        {
+            for(int i = 0; i < rows.size(); ++i)
+            {
+                if(!insertChunk(rows.mid(i, 1), key, ids))
+                    return false;
+            }
+            return true;
+        }
+
+        q->setBindings(QueryBuilder::InsertBinding, rows);
+        QString sql = grammar->compile(q, QueryBuilder::InsertStatement).join("; ");
+
+        Bindings values;
+        values.reserve(rows.size() * rows.first().size());
+        foreach (auto &row, rows)
+        {
+            for(auto it = row.constBegin(); it != row.constEnd(); ++it)
+                values.append(grammar->bindingValue(it.value()));
+        }
+
+        QVariant id = connection->insertGetId(sql, values);
+        if(!id.isValid())
+            return false;
+
+        appendIds(rows, key, id, ids);
+        return true;
+    }
+
+    int upsertChunk(QueryGrammar *grammar, const QList<QVariantMap> &rows,
+                    const QStringList &uniqueBy, const QStringList &update)
+    {
+        Q_Q(QueryBuilder);
+        QString sql = grammar->compileUpsert(q, rows, uniqueBy, update);
+        if(sql.isEmpty())
+            return -1;
+
+        Bindings values;
+        values.reserve(rows.size() * rows.first().size());
+        foreach (auto &row, rows)
+        {
+            for(auto it = row.constBegin(); it != row.constEnd(); ++it)
+                values.append(grammar->bindingValue(it.value()));
+        }
+
+        return connection->update(sql, values);
+    }
+
+    // takes the clauses of type off the query
+    ClauseList takeClauses(Clause::ClauseType type)
+    {
+        return clauses.take(type);
+    }
+
+    // drops the current clauses of type and puts back the taken ones
+    void restoreClauses(Clause::ClauseType type, const ClauseList &list)
+    {
+        removeClause(type);
+        if(!list.isEmpty())
+            clauses[type] = list;
+    }
+
+    // the configuration of the connection, a pooled one is named "name#serial"
+    QString connectionConfig() const
+    {
+        return connection ? connection->connectionName().section('#', 0, 0) : QString();
+    }
+
+    // reads the page of the cursor, returns false if it failed
+    bool fetch(QSqlQuery &query, QList<QVariantMap> &rows) const
+    {
+        rows.clear();
+        if(!query.isActive())
+            return false;
+
+        while(query.next())
+        {
+            QSqlRecord record = query.record();
+            QVariantMap row;
+            for(int i = 0; i < record.count(); ++i)
+                row.insert(record.fieldName(i), record.value(i));
+            rows.append(row);
+        }
+        QueryProfiler::instance()->consumed(query, rows.size());
+        query.finish();
+
+        return true;
+    }
+
     QueryBuilder *q_ptr = nullptr;
     Connection *connection = nullptr;
     Grammar *grammar = nullptr;
@@ -123,8 +347,9 @@ public:
     bool isDistincted = false;
     bool isAggregated = false;
 
-    QMap<int, QList<Clause*> > clauses;
+    QMap<int, ClauseList> clauses;
     BindingsHash bindings;
+    QExplicitlySharedDataPointer<ClauseArena> arena; // not shared with copies, they make their own
 };
 
 /**
@@ -148,35 +373,41 @@ QueryBuilder::QueryBuilder(const Connection *connection)
 QueryBuilder::QueryBuilder(const QueryBuilder &other)
     : d_ptr(new QueryBuilderPrivate(this))
 {
-    *d_ptr.data() = *other.d_ptr.data();
+    d_ptr->assign(*other.d_ptr);
 }
 
 QueryBuilder::QueryBuilder(const QueryBuilder &&other)
     : d_ptr(new QueryBuilderPrivate(this))
 {
-    *d_ptr.data() = *other.d_ptr.data();
+    d_ptr->assign(*other.d_ptr);
 }
 
 QueryBuilder &QueryBuilder::operator=(const QueryBuilder &other)
 {
-    *d_ptr.data() = *other.d_ptr.data();
+    if(this != &other)
+        d_ptr->assign(*other.d_ptr);
     return *this;
 }
 
 QueryBuilder::~QueryBuilder()
 {
-    qDebug() << "QueryBuilder::~QueryBuilder()";
-    Q_D(QueryBuilder);
-    foreach (auto val, d->clauses) {
-        qDeleteAll(val);
-    }
-    d->clauses.clear();
+}
+
+bool QueryBuilder::isArenaEnabled()
+{
+    return g_arenaEnabled.load() != 0;
+}
+
+void QueryBuilder::setArenaEnabled(bool enabled)
+{
+    g_arenaEnabled.store(enabled ? 1 : 0);
 }
 
 void QueryBuilder::setConnection(const Connection *connection)
 {
     Q_D(QueryBuilder);
     d->connection = const_cast<Connection *>(connection);
+    d->grammar = d->connection ? d->connection->queryGrammar().get() : nullptr;
 }
 
 Connection *QueryBuilder::connection() const
@@ -191,13 +422,13 @@ Grammar *QueryBuilder::grammar() const
     return d->grammar;
 }
 
-QMap<int, QList<Clause *> > QueryBuilder::clauses() const
+QMap<int, ClauseList> QueryBuilder::clauses() const
 {
     Q_D(const QueryBuilder);
     return d->clauses;
 }
 
-QList<Clause *> QueryBuilder::clauses(int type) const
+ClauseList QueryBuilder::clauses(int type) const
 {
     Q_D(const QueryBuilder);
     return d->clauses.value(type);
@@ -273,12 +504,28 @@ QString QueryBuilder::toSql() const
     return d->grammar->compile(const_cast<QueryBuilder *>(this), SelectStatement).join(" ");
 }
 
+QString QueryBuilder::toPreparedSql(Bindings &bindings, int type) const
+{
+    Q_D(const QueryBuilder);
+    QueryBuilder *builder = const_cast<QueryBuilder *>(this);
+    QueryGrammar *grammar = qobject_cast<QueryGrammar *>(d->grammar);
+    if(!grammar)
+    {
+        bindings.clear();
+        return d->grammar->compile(builder, type).join("; ");
+    }
+
+    QueryGrammar::Prepared prepared = grammar->compilePrepared(builder, type);
+    bindings = prepared.bindings;
+    return prepared.sql;
+}
+
 bool QueryBuilder::exists()
 {
     Q_D(QueryBuilder);
-    QStringList statements = d->grammar->compile(this, ExistsStatement);
-    QString query = statements.join("; ");
-    QSqlQuery result = d->connection->select(query);
+    Bindings bindings;
+    QString query = this->toPreparedSql(bindings, ExistsStatement);
+    QSqlQuery result = d->connection->select(query, bindings);
 
     return result.next() && result.value(0).toBool();
 }
@@ -291,21 +538,60 @@ bool QueryBuilder::insert(const QVariantMap &value)
     QStringList statements = d->grammar->compile(this, InsertStatement);
     QString query = statements.join("; ");
 
-    return d->connection->insert(query, value);
+    Bindings bindings;
+    bindings.reserve(value.size());
+    for(auto it = value.constBegin(); it != value.constEnd(); ++it)
+        bindings << d->grammar->bindingValue(it.value());
+
+    return d->connection->insert(query, bindings);
 }
 
 bool QueryBuilder::insert(const QList<QVariantMap> &values)
 {
-    Q_D(QueryBuilder);
-
     if(values.isEmpty())
         return true;
 
-    this->setBindings(InsertBinding, values);
-    QStringList statements = d->grammar->compile(this, InsertStatement);
-    QString query = statements.join("; ");
+    return !this->insertGetIds(values).isEmpty();
+}
+
+QVariantList QueryBuilder::insertGetIds(const QList<QVariantMap> &values, const QString &key)
+{
+    Q_D(QueryBuilder);
+    QVariantList ids;
+    if(values.isEmpty())
+        return ids;
+
+    // all the chunks are committed together by the writer
+    if(d->connection && !d->connection->isWritable())
+    {
+        QueryBuilder query(*this);
+        bool ok = d->connection->write([&query, &values, &key, &ids](Connection *db) -> bool {
+            query.setConnection(db);
+            ids = query.insertGetIds(values, key);
+            return !ids.isEmpty();
+        });
+        return ok ? ids : QVariantList();
+    }
+
+    const QStringList columns = values.first().keys();
+    const QList<QVariantMap> rows = d->normalize(values, columns);
+
+    QueryGrammar *grammar = qobject_cast<QueryGrammar *>(d->grammar);
+    int maxBindings = grammar ? grammar->maxBindings() : 999;
+    int chunkSize = qBound(1, maxBindings / qMax(1, columns.size()), MaxInsertChunk);
+
+    // one transaction for all chunks: one journal sync instead of one per statement
+    TransactionGuard transaction(d->connection);
+
+    bool ok = true;
+    ids.reserve(rows.size());
+    for(int i = 0; ok && i < rows.size(); i += chunkSize)
+        ok = d->insertChunk(rows.mid(i, chunkSize), key, ids);
+
+    if(!ok || (transaction.isActive() && !transaction.commit()))
+        return QVariantList();
 
-    return d->connection->insert(query, values);
+    return ids;
 }
 
 qint64 QueryBuilder::update(const QVariantMap &value)
@@ -313,10 +599,120 @@ qint64 QueryBuilder::update(const QVariantMap &value)
     Q_D(QueryBuilder);
 
     this->addBinding(UpdateBinding, value); // TODO: binding sub query also
-    QStringList statements = d->grammar->compile(this, UpdateStatement);
-    QString query = statements.join("; ");
+    Bindings wheres;
+    QString query = this->toPreparedSql(wheres, UpdateStatement);
+
+    // the values of "set" come before the ones of the wheres
+    Bindings bindings;
+    bindings.reserve(value.size() + wheres.size());
+    for(auto it = value.constBegin(); it != value.constEnd(); ++it)
+        bindings << d->grammar->bindingValue(it.value());
+    bindings << wheres;
+
+    return d->connection->update(query, bindings);
+}
+
+int QueryBuilder::upsert(const QList<QVariantMap> &values, const QStringList &uniqueBy,
+                         const QStringList &update)
+{
+    Q_D(QueryBuilder);
+    if(values.isEmpty())
+        return 0;
+
+    QueryGrammar *grammar = qobject_cast<QueryGrammar *>(d->grammar);
+    if(!grammar || uniqueBy.isEmpty())
+    {
+        qWarning() << "upsert() needs a query grammar and the unique columns:" << d->table;
+        return -1;
+    }
+
+    if(d->connection && !d->connection->isWritable())
+    {
+        QueryBuilder query(*this);
+        int affected = -1;
+        bool ok = d->connection->write([&query, &values, &uniqueBy, &update, &affected](Connection *db) -> bool {
+            query.setConnection(db);
+            affected = query.upsert(values, uniqueBy, update);
+            return affected >= 0;
+        });
+        return ok ? affected : -1;
+    }
+
+    const QStringList columns = values.first().keys();
+    const QList<QVariantMap> rows = d->normalize(values, columns);
+
+    QStringList updates = update;
+    if(updates.isEmpty())
+    {
+        foreach (auto &column, columns)
+        {
+            if(!uniqueBy.contains(column))
+                updates << column;
+        }
+    }
 
-    return d->connection->update(query, value);
+    int chunkSize = qBound(1, grammar->maxBindings() / qMax(1, columns.size()), MaxInsertChunk);
+
+    TransactionGuard transaction(d->connection);
+
+    int affected = 0;
+    for(int i = 0; i < rows.size(); i += chunkSize)
+    {
+        int count = d->upsertChunk(grammar, rows.mid(i, chunkSize), uniqueBy, updates);
+        if(count < 0)
+            return -1;
+        affected += count;
+    }
+
+    if(transaction.isActive() && !transaction.commit())
+        return -1;
+
+    return affected;
+}
+
+QFuture<QList<QVariantMap> > QueryBuilder::getAsync(const QString &columns) const
+{
+    Q_D(const QueryBuilder);
+    QueryBuilder query(*this);
+    std::function<QList<QVariantMap>(Connection *)> job = [query, columns](Connection *connection) mutable {
+        query.setConnection(connection);
+        QSqlQuery result = query.get(columns);
+
+        QList<QVariantMap> rows;
+        query.d_func()->fetch(result, rows);
+        return rows;
+    };
+
+    return Database::instance()->executor()->run(d->connectionConfig(), job);
+}
+
+QFuture<bool> QueryBuilder::insertAsync(const QVariantMap &value) const
+{
+    return this->insertAsync(QList<QVariantMap>{value});
+}
+
+QFuture<bool> QueryBuilder::insertAsync(const QList<QVariantMap> &values) const
+{
+    Q_D(const QueryBuilder);
+    QueryBuilder query(*this);
+    std::function<bool(Connection *)> job = [query, values](Connection *connection) mutable {
+        query.setConnection(connection);
+        return query.insert(values);
+    };
+
+    return Database::instance()->executor()->run(d->connectionConfig(), job);
+}
+
+QFuture<qint64> QueryBuilder::updateAsync(const QVariantMap &value) const
+{
+    Q_D(const QueryBuilder);
+    QueryBuilder query(*this);
+    std::function<qint64(Connection *)> job = [query, value](Connection *connection) mutable {
+        query.setConnection(connection);
+        return query.update(value);
+    };
+
+    return Database::instance()->executor()->run(d->connectionConfig(), job);
 }
 
 bool QueryBuilder::updateOrInsert(const QVariantMap &attribute, const QVariantMap &value)
@@ -350,16 +746,15 @@ int QueryBuilder::destroy(const QVariant &id)
         this->where(d->table + ".id", "=", id);
     }
 
-    QString sql = d->grammar->compile(this, DeleteStatement).join("; ");
-    QVariantMap binding =  this->bindings(DeleteBinding).isEmpty()
-            ? QVariantMap() : this->bindings(DeleteBinding).first();
-    return this->connection()->del(sql, binding);
+    Bindings bindings;
+    QString sql = this->toPreparedSql(bindings, DeleteStatement);
+    return this->connection()->del(sql, bindings);
 }
 
 QueryBuilder &QueryBuilder::select(const QString &columns)
 {
     Q_D(QueryBuilder);
-    ColumnClause *col = new ColumnClause(columns, this);
+    ColumnClause *col = d->make<ColumnClause>(columns, this);
     d->setClause(Clause::Column, col);
 
     return *this;
@@ -372,7 +767,7 @@ QueryBuilder &QueryBuilder::select(const QStringList &columns)
     // TODO: any column of columns is queryable (sub query)
     // selectSub(query, as)
 
-    ColumnClause *col = new ColumnClause(columns, this);
+    ColumnClause *col = d->make<ColumnClause>(columns, this);
     d->setClause(Clause::Column, col);
 
     return *this;
@@ -427,7 +822,7 @@ QueryBuilder &QueryBuilder::addSelect(const QString &column)
 {
     Q_D(QueryBuilder);
 
-    d->addClause(Clause::Column, new ColumnClause(column, this));
+    d->addClause(Clause::Column, d->make<ColumnClause>(column, this));
 
     return *this;
 }
@@ -436,7 +831,7 @@ QueryBuilder &QueryBuilder::from(const QString &table, const QString &as)
 {
     Q_D(QueryBuilder);
     // remove this clause?
-    FromClause *fc = new FromClause(table, as);
+    FromClause *fc = d->make<FromClause>(table, as);
     d->setClause(Clause::From, fc);
     d->table = fc->table();
 
@@ -476,13 +871,15 @@ QSqlQuery QueryBuilder::get(const QString &columns)
 {
     Q_D(QueryBuilder);
 
-    QList<Clause *> orignal = d->clauses.value(Clause::Column);
+    ClauseList orignal = d->clauses.value(Clause::Column);
 
     if(d->hasClause(Clause::Column))
     {
-        d->setClause(Clause::Column, new ColumnClause(columns, this));
+        d->setClause(Clause::Column, d->make<ColumnClause>(columns, this));
     }
-    QSqlQuery query = d->connection->select(this->toSql());
+    Bindings bindings;
+    QString sql = this->toPreparedSql(bindings);
+    QSqlQuery query = d->connection->select(sql, bindings);
 
     d->setClause(Clause::Column, orignal);
 
@@ -494,13 +891,153 @@ QSqlQuery QueryBuilder::get(const QStringList &columns)
     return this->get(columns.join(", "));
 }
 
+QSqlQuery QueryBuilder::cursor(const QString &columns)
+{
+    Q_D(QueryBuilder);
+
+    bool selected = !d->clauses.value(Clause::Column).isEmpty();
+    if(!selected)
+        d->setClause(Clause::Column, d->make<ColumnClause>(columns, this));
+
+    Bindings bindings;
+    QString sql = this->toPreparedSql(bindings);
+    QSqlQuery query = d->connection->cursor(sql, bindings);
+
+    if(!selected)
+        d->removeClause(Clause::Column);
+
+    return query;
+}
+
+ResultSet QueryBuilder::results(const QString &columns)
+{
+    QSqlQuery query = this->cursor(columns);
+    return ResultSet::fromQuery(query);
+}
+
+bool QueryBuilder::chunk(int count, ChunkCallback callback)
+{
+    Q_D(QueryBuilder);
+    if(count <= 0)
+        return false;
+
+    if(d->clauses.value(Clause::Order).isEmpty() && d->clauses.value(Clause::UnionOrder).isEmpty())
+        qWarning() << "chunk() without an order, the pages may overlap:" << d->table;
+
+    ClauseList limit = d->takeClauses(Clause::Limit);
+    ClauseList offset = d->takeClauses(Clause::Offset);
+
+    bool ok = true;
+    QList<QVariantMap> rows;
+    for(int page = 1; ok; ++page)
+    {
+        d->removeClause(Clause::Limit);
+        d->removeClause(Clause::Offset);
+        this->forPage(page, count);
+
+        QSqlQuery query = this->cursor();
+        if(!d->fetch(query, rows))
+        {
+            ok = false;
+            break;
+        }
+
+        if(rows.isEmpty())
+            break;
+
+        if(!callback(rows, page))
+            ok = false;
+        else if(rows.size() < count)
+            break;
+    }
+
+    d->restoreClauses(Clause::Limit, limit);
+    d->restoreClauses(Clause::Offset, offset);
+
+    return ok;
+}
+
+bool QueryBuilder::chunkById(int count, ChunkCallback callback, const QString &column, const QString &alias)
+{
+    Q_D(QueryBuilder);
+    if(count <= 0)
+        return false;
+
+    QString key = alias.isEmpty() ? column : alias;
+    ClauseList order = d->takeClauses(Clause::Order);
+    ClauseList limit = d->takeClauses(Clause::Limit);
+    ClauseList offset = d->takeClauses(Clause::Offset);
+    const ClauseList wheres = d->clauses.value(Clause::Where);
+
+    d->setClause(Clause::Order, d->make<OrderClause>(column, "asc"));
+    d->setClause(Clause::Limit, d->make<LimitClause>(count));
+
+    bool ok = true;
+    QVariant lastId;
+    QList<QVariantMap> rows;
+    for(int page = 1; ok; ++page)
+    {
+        // the id condition is only added for the duration of one page
+        if(lastId.isValid())
+        {
+            WhereClause *after = d->make<WhereClause>(WhereClause::Base, column, QString(">"), lastId, "and");
+            d->addClause(Clause::Where, after);
+        }
+
+        QSqlQuery query = this->cursor();
+        bool fetched = d->fetch(query, rows);
+
+        d->restoreClauses(Clause::Where, wheres);
+
+        if(!fetched)
+        {
+            ok = false;
+            break;
+        }
+
+        if(rows.isEmpty())
+            break;
+
+        lastId = rows.last().value(key);
+        if(!lastId.isValid())
+        {
+            qWarning() << "chunkById() column is not in the result:" << key;
+            ok = false;
+            break;
+        }
+
+        if(!callback(rows, page))
+            ok = false;
+        else if(rows.size() < count)
+            break;
+    }
+
+    d->restoreClauses(Clause::Order, order);
+    d->restoreClauses(Clause::Limit, limit);
+    d->restoreClauses(Clause::Offset, offset);
+
+    return ok;
+}
+
+bool QueryBuilder::each(RowCallback callback, int count)
+{
+    return this->chunk(count, [callback](const QList<QVariantMap> &rows, int) -> bool {
+        foreach (auto &row, rows)
+        {
+            if(!callback(row))
+                return false;
+        }
+        return true;
+    });
+}
+
 QueryBuilder &QueryBuilder::join(const QString &table, const QString &first,
                                  const QString &op, const QString &second,
                                  const QString &type, bool where)
 {
     Q_D(QueryBuilder);
 
-    JoinClause *join = new JoinClause(this, type, table, where);
+    JoinClause *join = d->make<JoinClause>(this, type, table, where);
     where ? join->where(first, op, second) : join->on(first, op, second);
     d->addClause(Clause::Join, join);
 
@@ -539,11 +1076,11 @@ QueryBuilder &QueryBuilder::where(const QString &column, const QVariant &op,
     WhereClause *where = nullptr;
     if(invalidOperator(op.toString()))
     {
-        where = new WhereClause(WhereClause::Base, column, QString("="), op, boolean);
+        where = d->make<WhereClause>(WhereClause::Base, column, QString("="), op, boolean);
     }
     else
     {
-        where = new WhereClause(WhereClause::Base, column, op.toString(), value, boolean);
+        where = d->make<WhereClause>(WhereClause::Base, column, op.toString(), value, boolean);
     }
     d->addClause(Clause::Where, where);
 
@@ -592,11 +1129,11 @@ QueryBuilder &QueryBuilder::whereColumn(const QString &first, const QString &op,
     WhereClause *where = nullptr;
     if(invalidOperator(op))
     {
-        where = new WhereClause(WhereClause::Column, QString("="), op, boolean);
+        where = d->make<WhereClause>(WhereClause::Column, QString("="), op, boolean);
     }
     else
     {
-        where = new WhereClause(WhereClause::Column, first, op, second, boolean);
+        where = d->make<WhereClause>(WhereClause::Column, first, op, second, boolean);
     }
 
     d->addClause(Clause::Where, where);
@@ -615,7 +1152,7 @@ QueryBuilder &QueryBuilder::whereIn(const QString &column, const QVariant &value
     Q_D(QueryBuilder);
 
     // TODO: create sub query if value is queryable and add bindings
-    WhereClause *where = new WhereClause(WhereClause::In, column, value, boolean);
+    WhereClause *where = d->make<WhereClause>(WhereClause::In, column, value, boolean);
     d->addClause(Clause::Where, where);
 
     return *this;
@@ -630,7 +1167,7 @@ QueryBuilder &QueryBuilder::whereNotIn(const QString &column, const QVariant &va
 {
     Q_D(QueryBuilder);
 
-    WhereClause *where = new WhereClause(WhereClause::NotIn, column, value, boolean);
+    WhereClause *where = d->make<WhereClause>(WhereClause::NotIn, column, value, boolean);
     d->addClause(Clause::Where, where);
 
     return *this;
@@ -645,7 +1182,7 @@ QueryBuilder &QueryBuilder::whereNull(const QString &column, const QString &bool
 {
     Q_D(QueryBuilder);
 
-    WhereClause *where = new WhereClause(WhereClause::Null, column, QVariant(), boolean);
+    WhereClause *where = d->make<WhereClause>(WhereClause::Null, column, QVariant(), boolean);
     d->addClause(Clause::Where, where);
 
     return *this;
@@ -660,7 +1197,7 @@ QueryBuilder &QueryBuilder::whereNotNull(const QString &column, const QString bo
 {
     Q_D(QueryBuilder);
 
-    WhereClause *where = new WhereClause(WhereClause::NotNull, column, QVariant(), boolean);
+    WhereClause *where = d->make<WhereClause>(WhereClause::NotNull, column, QVariant(), boolean);
     d->addClause(Clause::Where, where);
 
     return *this;
@@ -676,7 +1213,7 @@ QueryBuilder &QueryBuilder::whereBetween(const QString &column, const QVariant &
 {
     Q_D(QueryBuilder);
 
-    WhereClause *where = new WhereClause(negate ? WhereClause::NotBetween : WhereClause::Between,
+    WhereClause *where = d->make<WhereClause>(negate ? WhereClause::NotBetween : WhereClause::Between,
                                          column, value, boolean);
     d->addClause(Clause::Where, where);
 
@@ -692,7 +1229,7 @@ QueryBuilder &QueryBuilder::whereNotBetween(const QString &column, const QVarian
                                             const QString boolean)
 {
     Q_D(QueryBuilder);
-    WhereClause *where = new WhereClause(WhereClause::NotBetween, column, value, boolean);
+    WhereClause *where = d->make<WhereClause>(WhereClause::NotBetween, column, value, boolean);
     d->addClause(Clause::Where, where);
 
     return *this;
@@ -712,11 +1249,11 @@ QueryBuilder &QueryBuilder::whereDate(const QString &column, const QString &op,
     if(value.type() == QVariant::String)
     {
         QDate val = QDate::fromString(value.toString(), d->grammar->dateFormat());
-        where = new WhereClause(WhereClause::Date, column, op, val, boolean);
+        where = d->make<WhereClause>(WhereClause::Date, column, op, val, boolean);
     }
     else
     {
-        where = new WhereClause(WhereClause::Date, column, op, value, boolean);
+        where = d->make<WhereClause>(WhereClause::Date, column, op, value, boolean);
     }
 
     d->addClause(Clause::Where, where);
@@ -739,11 +1276,11 @@ QueryBuilder &QueryBuilder::whereTime(const QString &column, const QString &op,
     if(value.type() == QVariant::String)
     {
         QDate val = QDate::fromString(value.toString(), d->grammar->datetimeFormat());
-        where = new WhereClause(WhereClause::Date, column, op, val, boolean);
+        where = d->make<WhereClause>(WhereClause::Date, column, op, val, boolean);
     }
     else
     {
-        where = new WhereClause(WhereClause::Date, column, op, value, boolean);
+        where = d->make<WhereClause>(WhereClause::Date, column, op, value, boolean);
     }
 
     d->addClause(Clause::Where, where);
@@ -766,7 +1303,7 @@ QueryBuilder &QueryBuilder::whereDay(const QString &column, const QString &op,
     if(value.type() == QVariant::String)
     {
         QDate val = QDate::fromString(value.toString(), Qt::ISODate);
-        where = new WhereClause(WhereClause::Day, column, op, val.day(), boolean);
+        where = d->make<WhereClause>(WhereClause::Day, column, op, val.day(), boolean);
     }
     else
     {
@@ -774,7 +1311,7 @@ QueryBuilder &QueryBuilder::whereDay(const QString &column, const QString &op,
         if(value.type() == QVariant::Date || value.type() == QVariant::DateTime)
             val = value.toDate().day();
 
-        where = new WhereClause(WhereClause::Day, column, op, val, boolean);
+        where = d->make<WhereClause>(WhereClause::Day, column, op, val, boolean);
     }
 
     d->addClause(Clause::Where, where);
@@ -796,7 +1333,7 @@ QueryBuilder &QueryBuilder::whereMonth(const QString &column, const QString &op,
     if(value.type() == QVariant::String)
     {
         QDate val = QDate::fromString(value.toString(), Qt::ISODate);
-        where = new WhereClause(WhereClause::Month, column, op, val.month(), boolean);
+        where = d->make<WhereClause>(WhereClause::Month, column, op, val.month(), boolean);
     }
     else
     {
@@ -804,7 +1341,7 @@ QueryBuilder &QueryBuilder::whereMonth(const QString &column, const QString &op,
         if(value.type() == QVariant::Date || value.type() == QVariant::DateTime)
             val = value.toDate().month();
 
-        where = new WhereClause(WhereClause::Month, column, op, val, boolean);
+        where = d->make<WhereClause>(WhereClause::Month, column, op, val, boolean);
     }
 
     d->addClause(Clause::Where, where);
@@ -826,7 +1363,7 @@ QueryBuilder &QueryBuilder::whereYear(const QString &column, const QString &op,
     if(value.type() == QVariant::String)
     {
         QDate val = QDate::fromString(value.toString(), Qt::ISODate);
-        where = new WhereClause(WhereClause::Year, column, op, val.year(), boolean);
+        where = d->make<WhereClause>(WhereClause::Year, column, op, val.year(), boolean);
     }
     else
     {
@@ -834,7 +1371,7 @@ QueryBuilder &QueryBuilder::whereYear(const QString &column, const QString &op,
         if(value.type() == QVariant::Date || value.type() == QVariant::DateTime)
             val = value.toDate().year();
 
-        where = new WhereClause(WhereClause::Year, column, op, val, boolean);
+        where = d->make<WhereClause>(WhereClause::Year, column, op, val, boolean);
     }
 
     d->addClause(Clause::Where, where);
@@ -856,7 +1393,7 @@ QueryBuilder &QueryBuilder::whereExists(std::function<void (QueryBuilder *)> cal
     QSharedPointer<QueryBuilder> query(new QueryBuilder(d->connection));
     callback(query.get());
 
-    WhereClause *where = new WhereClause(WhereClause::Exists, query, boolean);
+    WhereClause *where = d->make<WhereClause>(WhereClause::Exists, query, boolean);
     d->addClause(Clause::Where, where);
 
     return *this;
@@ -874,7 +1411,7 @@ QueryBuilder &QueryBuilder::whereNotExists(std::function<void (QueryBuilder *)>
     QSharedPointer<QueryBuilder> query(new QueryBuilder(d->connection));
     callback(query.data());
 
-    WhereClause *where = new WhereClause(WhereClause::Exists, query, boolean);
+    WhereClause *where = d->make<WhereClause>(WhereClause::Exists, query, boolean);
     d->addClause(Clause::Where, where);
 
     return *this;
@@ -896,7 +1433,7 @@ QueryBuilder &QueryBuilder::whereRowValues(const QStringList &columns, const QSt
         return *this;
     }
 
-    WhereClause *where = new WhereClause(WhereClause::RowValues, columns.join(", "),
+    WhereClause *where = d->make<WhereClause>(WhereClause::RowValues, columns.join(", "),
                                          op, values, boolean);
     d->addClause(Clause::Where, where);
 
@@ -911,7 +1448,7 @@ QueryBuilder &QueryBuilder::orWhereRowValues(const QStringList &columns, const Q
 QueryBuilder &QueryBuilder::groupBy(const QStringList &groups)
 {
     Q_D(QueryBuilder);
-    GroupClause *group = new GroupClause(groups);
+    GroupClause *group = d->make<GroupClause>(groups);
     d->setClause(Clause::GroupBy, group);
 
     return *this;
@@ -920,7 +1457,7 @@ QueryBuilder &QueryBuilder::groupBy(const QStringList &groups)
 QueryBuilder &QueryBuilder::groupBy(const QString &groups)
 {
     Q_D(QueryBuilder);
-    GroupClause *group = new GroupClause(groups);
+    GroupClause *group = d->make<GroupClause>(groups);
     d->setClause(Clause::GroupBy, group);
 
     return *this;
@@ -930,7 +1467,7 @@ QueryBuilder &QueryBuilder::having(const QString &column, const QString &op,
                                    const QVariant &value, const QString boolean)
 {
     Q_D(QueryBuilder);
-    HavingClause *having = new HavingClause(column, value, op, boolean);
+    HavingClause *having = d->make<HavingClause>(column, value, op, boolean);
     d->addClause(Clause::Having, having);
 
     return *this;
@@ -946,7 +1483,7 @@ QueryBuilder &QueryBuilder::havingBetween(const QString &column, const QVariant
                                           const QString boolean, bool negate)
 {
     Q_D(QueryBuilder);
-    HavingClause *having = new HavingClause(column, value, boolean, !negate);
+    HavingClause *having = d->make<HavingClause>(column, value, boolean, !negate);
     d->addClause(Clause::Having, having);
 
     return *this;
@@ -961,7 +1498,7 @@ QueryBuilder &QueryBuilder::havingNotBetween(const QString &column, const QVaria
                                              const QString boolean)
 {
     Q_D(QueryBuilder);
-    HavingClause *having = new HavingClause(column, value, boolean, false);
+    HavingClause *having = d->make<HavingClause>(column, value, boolean, false);
     d->addClause(Clause::Having, having);
 
     return *this;
@@ -979,7 +1516,7 @@ QueryBuilder &QueryBuilder::orderBy(const QString &column, const QString &direct
     if(QStringList({"asc", "desc"}).contains(sort))
         sort = "asc";
 
-    OrderClause *order = new OrderClause(column, direction);
+    OrderClause *order = d->make<OrderClause>(column, direction);
 
     Clause::ClauseType type = Clause::Order;
     if(!d->hasClause(Clause::Union))
@@ -1008,7 +1545,7 @@ QueryBuilder &QueryBuilder::oldest(const QString &column)
 QueryBuilder &QueryBuilder::offset(int value)
 {
     Q_D(QueryBuilder);
-    OffsetClause *offset = new OffsetClause(value);
+    OffsetClause *offset = d->make<OffsetClause>(value);
     d->setClause(Clause::Offset, offset);
 
     return *this;
@@ -1017,7 +1554,7 @@ QueryBuilder &QueryBuilder::offset(int value)
 QueryBuilder &QueryBuilder::limit(int value)
 {
     Q_D(QueryBuilder);
-    LimitClause *limit = new LimitClause(value);
+    LimitClause *limit = d->make<LimitClause>(value);
     d->setClause(Clause::Limit, limit);
 
     return *this;
@@ -1031,7 +1568,7 @@ QueryBuilder &QueryBuilder::forPage(int page, int perPage)
 QueryBuilder &QueryBuilder::unionAt(QueryBuilder *query, bool all)
 {
     Q_D(QueryBuilder);
-    UnionClause *_union = new UnionClause(query, all);
+    UnionClause *_union = d->make<UnionClause>(query, all);
     d->setClause(Clause::Union, _union);
 
     return *this;
@@ -1,15 +1,19 @@
 #ifndef QUERYBUILDER_H
 #define QUERYBUILDER_H
 
+#include "Clause.h"
+
 #include <QObject>
 #include <QSqlQuery>
 #include <QVariant>
+#include <QFuture>
 
 typedef QHash<int, QList<QVariantMap> > BindingsHash;
 
 class Connection;
+class Bindings;
+class ResultSet;
 class Grammar;
-class Clause;
 class QueryBuilderPrivate;
 class QueryBuilder
 {
@@ -60,20 +64,61 @@ public:
     bool isDistincted() const;
     bool isAggregated() const;
 
-    QMap<int, QList<Clause *> > clauses() const;
-    QList<Clause*> clauses(int type) const;
+    /**
+     * the clause lists are implicitly shared with the copies of the builder,
+     * adding a clause only copies the list it is added to.
+     */
+    QMap<int, ClauseList> clauses() const;
+    ClauseList clauses(int type) const;
+
+    /**
+     * the clauses of a builder come from an arena of its own, or from the
+     * heap when it is turned off, for comparing both. On by default.
+     */
+    static bool isArenaEnabled();
+    static void setArenaEnabled(bool enabled);
 
     QueryBuilder &setBindings(int bindingType, const QList<QVariantMap> &bindings);
     QueryBuilder &addBinding(int bindingType, const QVariantMap &value);
     QList<QVariantMap> bindings(QueryBuilder::BindingType type) const;
     BindingsHash bindings() const;
 
+    // SQL with the values inlined, used to embed the query into another one
     QString toSql() const;
+    // SQL with "?" place-holders, the values are returned in bindings
+    QString toPreparedSql(Bindings &bindings, int type = SelectStatement) const;
     bool exists();
     bool insert(const QVariantMap &value);
     bool insert(const QList< QVariantMap> &values);
+    /**
+     * insert the records in chunks sized to the grammar's bindings limit,
+     * all in one transaction. The columns are taken from the first record.
+     * returns the ids of the inserted rows in their order, an empty list if
+     * it failed: the given value of the key column, the generated one if the
+     * column is missing or null.
+     */
+    QVariantList insertGetIds(const QList<QVariantMap> &values, const QString &key = "id");
     qint64 update(const QVariantMap &value);
+
+    /**
+     * run a copy of the query on the database thread (see QueryExecutor) with
+     * a connection of its own, the builder may be changed or destroyed meanwhile.
+     * QueryExecutor::then() delivers the result back to the calling thread.
+     */
+    QFuture<QList<QVariantMap> > getAsync(const QString &columns = "*") const;
+    QFuture<bool> insertAsync(const QVariantMap &value) const;
+    QFuture<bool> insertAsync(const QList<QVariantMap> &values) const;
+    QFuture<qint64> updateAsync(const QVariantMap &value) const;
+    // an exists() query and then an insert or update, prefer upsert() on a unique index
     bool updateOrInsert(const QVariantMap &attribute, const QVariantMap &value);
+    /**
+     * insert the records in one statement per chunk, a row conflicting on the
+     * uniqueBy columns gets its update columns from the record instead; all
+     * the columns but uniqueBy when update is empty. All chunks run in one
+     * transaction. returns the affected rows, -1 if it failed.
+     */
+    int upsert(const QList<QVariantMap> &values, const QStringList &uniqueBy,
+               const QStringList &update = {});
     int destroy(const QVariant &id = QVariant());
 
     QueryBuilder &select(const QString &columns = "*");
@@ -92,6 +137,29 @@ public:
     QSqlQuery get(const QString &columns = "*");
     QSqlQuery get(const QStringList &columns = {"*"});
 
+    using ChunkCallback = std::function<bool(const QList<QVariantMap> &rows, int page)>;
+    using RowCallback = std::function<bool(const QVariantMap &row)>;
+
+    // a forward-only result, the rows are read from the database one by one by next()
+    QSqlQuery cursor(const QString &columns = "*");
+    // all rows stored by column, see ResultSet
+    ResultSet results(const QString &columns = "*");
+    /**
+     * run the query page by page (offset/limit) and pass every page of
+     * at most count rows to callback until it returns false.
+     * returns false if the callback stopped it or a page failed.
+     */
+    bool chunk(int count, ChunkCallback callback);
+    /**
+     * like chunk() but pages by "column > last id" ordered by column, which
+     * stays fast on large tables and is safe when the callback updates rows.
+     * alias is the name of the column in the result if it differs.
+     */
+    bool chunkById(int count, ChunkCallback callback,
+                   const QString &column = "id", const QString &alias = "");
+    // run callback for every row, chunked by count rows, until it returns false
+    bool each(RowCallback callback, int count = 1000);
+
     QueryBuilder &join(const QString &table, const QString &first, const QString &op = "",
                        const QString &second = "", const QString &type = "inner", bool where = false);
 
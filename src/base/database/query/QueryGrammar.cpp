@@ -5,10 +5,13 @@
 
 #include <QMetaObject>
 #include <QRegularExpression>
+#include <QThread>
 #include <QDebug>
 
+static const int DefaultCacheCapacity = 256;
+
 QueryGrammarPrivate::QueryGrammarPrivate(Grammar *q)
-    : GrammarPrivate(q)
+    : GrammarPrivate(q), cache(DefaultCacheCapacity)
 {
 
 }
@@ -36,12 +39,16 @@ QStringList QueryGrammarPrivate::compileClauses(QueryBuilder *builder) const
 QString QueryGrammarPrivate::compileClauses(QueryBuilder *builder, Clause::ClauseType type) const
 {
     QStringList segments;
-    QList<Clause*> clauses = builder->clauses(type);
+    const ClauseList clauses = builder->clauses(type);
     QueryGrammar *grammar = const_cast<QueryGrammar*>(q_func());
+
+    QueryBuilder *previous = compiling;
+    compiling = builder;
     for(int i = 0; i < clauses.size(); ++i)
     {
         segments << clauses[i]->interpret(grammar, i == 0);
     }
+    compiling = previous;
 
     QString result = segments.join(" ").trimmed();
     if(Clause::Union == type)
@@ -57,7 +64,7 @@ QString QueryGrammarPrivate::compileClauses(QueryBuilder *builder, Clause::Claus
 
 /**
  * @brief just remove first and / or string.
- *  this function absoleted. for details see \fn *Clause::leading().
+ *  this function absoleted. for details see \fn *Clause::interpret().
  * @param clause
  * @return
  */
@@ -79,11 +86,167 @@ QString QueryGrammarPrivate::removeLeadingBoolean(const QString clause) const
 
 QString QueryGrammarPrivate::dateWhere(const QString &type, WhereClause *where) const
 {
-    QString value = q_ptr->parameter(where->value());
+    Q_Q(const QueryGrammar);
+    QString value = q->bindParameter(where->value());
     QString column = q_ptr->wrap(where->columns().first());
     return QString("%1(%2) %3 %4").arg(type).arg(column).arg(where->op()).arg(value);
 }
 
+void QueryGrammarPrivate::fingerprint(QueryBuilder *builder, QString &key, Bindings &values, bool wheresOnly) const
+{
+    if(!builder)
+        return;
+
+    key += builder->isDistincted() ? "d" : "";
+    key += builder->isAggregated() ? "a" : "";
+
+    // walk the clauses in the same order as compileClauses()
+    const QMap<int, ClauseList> clauses = builder->clauses();
+    for(auto it = clauses.constBegin(); it != clauses.constEnd(); ++it)
+    {
+        if(wheresOnly && it.key() != Clause::Where)
+            continue;
+
+        foreach (auto &clause, it.value())
+            fingerprint(it.key(), clause.data(), key, values);
+
+        if(!wheresOnly && it.key() == Clause::Union)
+        {
+            foreach (auto &clause, builder->clauses(Clause::UnionOrder))
+                fingerprint(Clause::UnionOrder, clause.data(), key, values);
+        }
+    }
+}
+
+void QueryGrammarPrivate::fingerprint(int type, Clause *clause, QString &key, Bindings &values) const
+{
+    key += QString("|%1:%2").arg(type).arg(clause->columns().join(","));
+
+    switch (type)
+    {
+    case Clause::Aggregate:
+        key += ":" + static_cast<AggregateClause *>(clause)->function();
+        break;
+    case Clause::From:
+        key += ":" + static_cast<FromClause *>(clause)->table();
+        break;
+    case Clause::Join:
+    {
+        JoinClause *join = static_cast<JoinClause *>(clause);
+        key += ":" + join->joinType() + ":" + join->table() + "{";
+        fingerprint(join->subQuery().data(), key, values);
+        key += "}";
+        break;
+    }
+    case Clause::Where:
+    {
+        WhereClause *where = static_cast<WhereClause *>(clause);
+        key += QString(":%1:%2:%3").arg(where->type()).arg(where->op()).arg(where->boolean());
+
+        const QVariant value = where->value();
+        switch (where->type())
+        {
+        case WhereClause::Base:
+        case WhereClause::Date:
+        case WhereClause::Time:
+        case WhereClause::Day:
+        case WhereClause::Month:
+        case WhereClause::Year:
+            values << value;
+            break;
+        case WhereClause::In:
+        case WhereClause::NotIn:
+            if(!value.isValid())
+            {
+                key += ":!";
+            }
+            else if(value.canConvert(QVariant::List))
+            {
+                // the number of place-holders is part of the shape
+                QVariantList list = value.toList();
+                key += ":" + QString::number(list.size());
+                values << list;
+            }
+            else
+            {
+                values << value;
+            }
+            break;
+        case WhereClause::Between:
+        case WhereClause::NotBetween:
+            values << value.toList().first() << value.toList().last();
+            break;
+        case WhereClause::RowValues:
+            key += ":" + QString::number(value.toList().size());
+            values << value.toList();
+            break;
+        case WhereClause::InRaw:
+        case WhereClause::NotInRaw:
+            key += ":" + (value.isValid() ? value.toStringList().join(",") : QString("!"));
+            break;
+        case WhereClause::Column:
+            key += ":" + value.toString();
+            break;
+        case WhereClause::Nested:
+            key += "{";
+            fingerprint(where->subQuery().data(), key, values, true);
+            key += "}";
+            break;
+        case WhereClause::Exists:
+        case WhereClause::NotExists:
+        case WhereClause::Sub:
+            key += "{";
+            fingerprint(where->subQuery().data(), key, values);
+            key += "}";
+            break;
+        default:
+            break;
+        }
+        break;
+    }
+    case Clause::Having:
+    {
+        HavingClause *having = static_cast<HavingClause *>(clause);
+        key += QString(":%1:%2").arg(having->op()).arg(having->boolean());
+        if(having->value().type() == QVariant::List)
+        {
+            key += having->betweenOrNot() ? ":between" : ":not between";
+            values << having->value().toList().first() << having->value().toList().last();
+        }
+        else
+        {
+            values << having->value();
+        }
+        break;
+    }
+    case Clause::Order:
+    case Clause::UnionOrder:
+        key += ":" + static_cast<OrderClause *>(clause)->direction();
+        break;
+    case Clause::Union:
+    {
+        UnionClause *uc = static_cast<UnionClause *>(clause);
+        key += uc->all() ? ":all{" : "{";
+        fingerprint(uc->query(), key, values);
+        key += "}";
+        break;
+    }
+    case Clause::Limit:
+        key += ":" + QString::number(static_cast<LimitClause *>(clause)->value());
+        break;
+    case Clause::Offset:
+        key += ":" + QString::number(static_cast<OffsetClause *>(clause)->value());
+        break;
+    default:
+        break;
+    }
+}
+
+bool QueryGrammarPrivate::isPreparing() const
+{
+    return preparingThread && preparingThread == QThread::currentThread();
+}
+
 /**
  * @brief QueryGrammar::QueryGrammar
  */
@@ -100,8 +263,6 @@ QueryGrammar::~QueryGrammar()
 
 QStringList QueryGrammar::compile(void *data, int type)
 {
-    qDebug() << "QueryGrammar::compile()";
-
 //    QSharedPointer<QueryBuilder> query(static_cast<QueryBuilder *>(data));
     QueryBuilder *query = static_cast<QueryBuilder *>(data);
     if(!query)
@@ -145,19 +306,119 @@ QStringList QueryGrammar::compile(void *data, int type)
         break;
     }
 
-    qDebug() << statements.join("; ");
-
     return statements;
 }
 
-QString QueryGrammar::compileSelect(QueryBuilder *builder) const
+QueryGrammar::Prepared QueryGrammar::compilePrepared(QueryBuilder *builder, int type)
+{
+    Q_D(QueryGrammar);
+    Prepared result;
+    if(!builder)
+        return result;
+
+    bool cacheable = isCacheEnabled()
+            && (type == QueryBuilder::SelectStatement || type == QueryBuilder::ExistsStatement);
+
+    QString key;
+    Bindings values;
+    if(cacheable)
+    {
+        key = QString::number(type);
+        d->fingerprint(builder, key, values);
+
+        QMutexLocker lock(&d->cacheMutex);
+        if(QString *sql = d->cache.object(key))
+        {
+            ++d->cacheHits;
+            result.sql = *sql;
+            for(QVariant &value : values)
+                value = bindingValue(value);
+            result.bindings = values;
+            return result;
+        }
+
+        ++d->cacheMisses;
+    }
+
+    {
+        QMutexLocker lock(&d->prepareMutex);
+        d->preparingThread = QThread::currentThread();
+        d->prepared.clear();
+        result.sql = this->compile(builder, type).join("; ");
+        result.bindings = d->prepared;
+        d->prepared.clear();
+        d->preparingThread = nullptr;
+    }
+
+    if(cacheable)
+    {
+        // a clause compiled outside of this grammar inlines its values
+        if(values.size() != result.bindings.size())
+        {
+            qWarning() << "Could not cache the statement, bindings do not match its shape:" << result.sql;
+            return result;
+        }
+
+        QMutexLocker lock(&d->cacheMutex);
+        d->cache.insert(key, new QString(result.sql));
+    }
+
+    return result;
+}
+
+bool QueryGrammar::isCacheEnabled() const
+{
+    Q_D(const QueryGrammar);
+    QMutexLocker lock(&d->cacheMutex);
+    return d->cacheEnabled;
+}
+
+void QueryGrammar::setCacheEnabled(bool enabled)
+{
+    Q_D(QueryGrammar);
+    QMutexLocker lock(&d->cacheMutex);
+    d->cacheEnabled = enabled;
+    if(!enabled)
+        d->cache.clear();
+}
+
+void QueryGrammar::clearCache()
+{
+    Q_D(QueryGrammar);
+    QMutexLocker lock(&d->cacheMutex);
+    d->cache.clear();
+    d->cacheHits = d->cacheMisses = 0;
+}
+
+int QueryGrammar::cacheCount() const
+{
+    Q_D(const QueryGrammar);
+    QMutexLocker lock(&d->cacheMutex);
+    return d->cache.count();
+}
+
+qint64 QueryGrammar::cacheHits() const
+{
+    Q_D(const QueryGrammar);
+    QMutexLocker lock(&d->cacheMutex);
+    return d->cacheHits;
+}
+
+qint64 QueryGrammar::cacheMisses() const
 {
     Q_D(const QueryGrammar);
+    QMutexLocker lock(&d->cacheMutex);
+    return d->cacheMisses;
+}
 
-    if(builder->clauses(Clause::Column).isEmpty())
-        builder->addClause(Clause::Column, new ColumnClause("*", builder));
+QString QueryGrammar::compileSelect(QueryBuilder *builder) const
+{
+    Q_D(const QueryGrammar);
 
     QStringList statements = d->compileClauses(builder);
+    // the default columns are not added to the builder, sub queries are shared across threads
+    if(builder->clauses(Clause::Column).isEmpty() && !builder->isAggregated())
+        statements.prepend(builder->isDistincted() ? "select distinct *" : "select *");
 
     if(!builder->clauses(Clause::Union).isEmpty() && builder->isAggregated())
     {
@@ -209,6 +470,23 @@ QString QueryGrammar::compileInsert(QueryBuilder *builder, const Records &values
             .arg(table).arg(columns).arg(parameters);
 }
 
+QString QueryGrammar::compileUpsert(QueryBuilder *builder, const Records &values,
+                                   const QStringList &uniqueBy, const QStringList &update)
+{
+    Q_UNUSED(builder)
+    Q_UNUSED(values)
+    Q_UNUSED(uniqueBy)
+    Q_UNUSED(update)
+    qWarning() << "This database grammar does not support upsert.";
+    return QString();
+}
+
+int QueryGrammar::maxBindings() const
+{
+    // SQLITE_MAX_VARIABLE_NUMBER before SQLite 3.32, lower than any other driver
+    return 999;
+}
+
 QString QueryGrammar::compileUpdate(QueryBuilder *builder, const Records &values)
 {
     Q_D(QueryGrammar);
@@ -278,8 +556,14 @@ QString QueryGrammar::compileRollBack(const QString &name)
     return "rollback to savepoint " + name;
 }
 
+QString QueryGrammar::compileReleaseSavepoint(const QString &name)
+{
+    return "release savepoint " + name;
+}
+
 QString QueryGrammar::clauseAggregate(AggregateClause *ac)  const
 {
+    Q_D(const QueryGrammar);
 //    if(!ac->query()->isAggregated())
 //        return "";
 
@@ -287,7 +571,7 @@ QString QueryGrammar::clauseAggregate(AggregateClause *ac)  const
     // 如果查询有一个“distinct”约束，并且没有要求所有列，
     // 那么我们需要在列名之前加上“distinct”，
     // 以便在对数据执行聚合操作时考虑到它。
-    if(ac->query()->isDistincted() && columns != "*")
+    if(d->builderOf(ac)->isDistincted() && columns != "*")
         columns = "distinct " + columns;
 
     return QString("select %1(%2) as aggregate")
@@ -299,10 +583,12 @@ QString QueryGrammar::clauseColumn(ColumnClause *cc) const
 {
     // 如果查询执行的是一个聚合select，我们让聚合编译函数处理select子句的构建，
     // 因为它需要更多的语法，最好由该函数来处理，以保持一切整洁。
-    if(cc->query()->isAggregated())
+    Q_D(const QueryGrammar);
+    QueryBuilder *builder = d->builderOf(cc);
+    if(builder->isAggregated())
         return "";
 
-    QString select = cc->query()->isDistincted() ?
+    QString select = builder->isDistincted() ?
                 "select distinct " : "select ";
 
     // TODO: handling column bindings here?
@@ -319,7 +605,7 @@ QString QueryGrammar::clauseFrom(FromClause *fc) const
     return "from " + this->wrapTable(fc->table());
 }
 
-QString QueryGrammar::clauseWhere(WhereClause *where)
+QString QueryGrammar::clauseWhere(WhereClause *where, bool leading)
 {
     // invoke where*();
     QString invokeMethod = where->whereMethod();
@@ -337,23 +623,21 @@ QString QueryGrammar::clauseWhere(WhereClause *where)
 
     //TODO: is the join query where?(see clauseJoin(...))
 
-    return where->leading() ? "where " + retVal : where->boolean() + " " + retVal;
+    return leading ? "where " + retVal : where->boolean() + " " + retVal;
 }
 
-QString QueryGrammar::clauseHaving(HavingClause *having) const
+QString QueryGrammar::clauseHaving(HavingClause *having, bool leading) const
 {
     QString column = this->wrap(having->columns().first());
-    QString parameter = this->parameter(having->value());
-    QString leading = having->leading() ? "having" : having->boolean();
-
+    QString parameter = this->bindParameter(having->value());
     return QString("%1 %2 %3 %4")
-            .arg(leading)
+            .arg(leading ? "having" : having->boolean())
             .arg(column)
             .arg(having->op())
             .arg(parameter);
 }
 
-QString QueryGrammar::clauseHavingBetween(HavingClause *having) const
+QString QueryGrammar::clauseHavingBetween(HavingClause *having, bool leading) const
 {
     QString column = this->wrap(having->columns().first());
     QString between = having->betweenOrNot() ? "between" :  "not between";
@@ -364,10 +648,10 @@ QString QueryGrammar::clauseHavingBetween(HavingClause *having) const
         return "";
     }
 
-    QString min = this->parameter(values.first());
-    QString max = this->parameter(values.last());
+    QString min = this->bindParameter(values.first());
+    QString max = this->bindParameter(values.last());
     return QString("%1 %2 %3 %4 and %5")
-            .arg(having->boolean())
+            .arg(leading ? "having" : having->boolean())
             .arg(column).arg(between).arg(min).arg(max);
 }
 
@@ -398,15 +682,13 @@ QString QueryGrammar::clauseJoin(JoinClause *join) const
             .arg(wheres.join(" "));
 }
 
-QString QueryGrammar::clauseOrder(OrderClause *order) const
+QString QueryGrammar::clauseOrder(OrderClause *order, bool leading) const
 {
     if(order->columns().isEmpty())
         return QString();
 
-    QString leading = order->leading() ? "order by " : "";
-
     return QString("%1%2 %3")
-            .arg(leading)
+            .arg(leading ? "order by " : "")
             .arg(wrap(order->columns().first()))
             .arg(order->direction());
 }
@@ -429,7 +711,7 @@ QString QueryGrammar::clauseOffset(OffsetClause *offset) const
 
 QString QueryGrammar::where(WhereClause *where) const
 {
-    return wrap(where->columns().first()) + " " + where->op() + " " + parameter(where->value());
+    return wrap(where->columns().first()) + " " + where->op() + " " + bindParameter(where->value());
 }
 
 QString QueryGrammar::whereIn(WhereClause *where) const
@@ -438,8 +720,8 @@ QString QueryGrammar::whereIn(WhereClause *where) const
     if(values.isValid())
     {
         QString result = values.canConvert(QVariant::List)
-                ? parameterize(values.toList())
-                : parameter(values);
+                ? bindParameters(values.toList())
+                : bindParameter(values);
         return wrap(where->columns().first()) + " in (" + result + ")";
     }
 
@@ -452,8 +734,8 @@ QString QueryGrammar::whereNotIn(WhereClause *where) const
     if(values.isValid())
     {
         QString result = values.canConvert(QVariant::List)
-                ? parameterize(values.toList())
-                : parameter(values);
+                ? bindParameters(values.toList())
+                : bindParameter(values);
         return wrap(where->columns().first()) + " not in (" + result + ")";
     }
 
@@ -497,8 +779,8 @@ QString QueryGrammar::whereNotNull(WhereClause *where) const
 QString QueryGrammar::whereBetween(WhereClause *where) const
 {
     QString between = where->type() == WhereClause::Between ? "between" : "not between";
-    QString min = parameter(where->value().toList().first());
-    QString max = parameter(where->value().toList().last());
+    QString min = bindParameter(where->value().toList().first());
+    QString max = bindParameter(where->value().toList().last());
 
     return QString("%1 %2 %3 and %4")
             .arg(wrap(where->columns().first()))
@@ -562,7 +844,7 @@ QString QueryGrammar::whereNotExists(WhereClause *where) const
 QString QueryGrammar::whereRowValues(WhereClause *where) const
 {
     QString columns = columnize(where->columns());
-    QString values = parameterize(where->value().toList());
+    QString values = bindParameters(where->value().toList());
     return QString("(%1) %2 (%3)").arg(columns).arg(where->op()).arg(values);
 }
 
@@ -595,3 +877,21 @@ void QueryGrammar::removeClause(QueryBuilder *builder, Clause::ClauseType type)
     builder->removeClause(type);
 }
 
+QString QueryGrammar::bindParameter(const QVariant &value) const
+{
+    Q_D(const QueryGrammar);
+    if(!d->isPreparing())
+        return parameter(value);
+
+    d->prepared.append(bindingValue(value));
+    return "?";
+}
+
+QString QueryGrammar::bindParameters(const QVariantList &values) const
+{
+    QStringList list;
+    foreach(auto &val, values)
+        list.append(this->bindParameter(val));
+
+    return list.join(", ");
+}
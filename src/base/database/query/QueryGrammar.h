@@ -3,6 +3,7 @@
 
 #include "Grammar.h"
 #include "Clause.h"
+#include "Bindings.h"
 
 #include <QVariant>
 
@@ -15,20 +16,51 @@ class QueryGrammar : public Grammar
 public:
     using Records = QList< QVariantMap >;
 
+    // SQL text with "?" place-holders and the values bound to them, in order
+    struct Prepared
+    {
+        QString sql;
+        Bindings bindings;
+    };
+
     QueryGrammar(QObject *parent = nullptr);
     ~QueryGrammar() override;
 
     virtual QStringList compile(void *builder, int type) override;
 
+    /**
+     * compile the builder with "?" place-holders for the where/having values.
+     * select and exists statements are cached by the shape of their clauses,
+     * so a query with a known shape only collects its values.
+     */
+    Prepared compilePrepared(QueryBuilder *builder, int type);
+
+    bool isCacheEnabled() const;
+    void setCacheEnabled(bool enabled);
+    void clearCache();
+    int cacheCount() const;
+    qint64 cacheHits() const;
+    qint64 cacheMisses() const;
+
     virtual QString compileSelect(QueryBuilder *builder) const;
     virtual QString compileInsert(QueryBuilder *builder, const Records &values);
+    // the most place-holders a single statement may bind
+    virtual int maxBindings() const;
     virtual QString compileUpdate(QueryBuilder *builder, const Records &values);
+    /**
+     * insert values, a row conflicting on the uniqueBy columns has its update
+     * columns set to the values of the insert instead. Empty if the driver
+     * has no native upsert.
+     */
+    virtual QString compileUpsert(QueryBuilder *builder, const Records &values,
+                                  const QStringList &uniqueBy, const QStringList &update);
     virtual QString compileDelete(QueryBuilder *builder);
     virtual QString compileExists(QueryBuilder *builder);
     virtual QString compileRandom(const QString &seed);
     virtual QString compileTruncate(const QString &table);
     virtual QString compileSavepoint(const QString &name);
     virtual QString compileRollBack(const QString &name);
+    virtual QString compileReleaseSavepoint(const QString &name);
 
     /**
      * compile clause components (interpret by clause)
@@ -36,12 +68,13 @@ public:
     virtual QString clauseAggregate(AggregateClause *ac) const;
     virtual QString clauseColumn(ColumnClause *cc) const;
     virtual QString clauseFrom(FromClause *fc) const;
-    virtual QString clauseWhere(WhereClause *where);
-    virtual QString clauseHaving(HavingClause *having) const;
-    virtual QString clauseHavingBetween(HavingClause *having) const;
+    // leading: the first clause of its kind, it starts with the keyword
+    virtual QString clauseWhere(WhereClause *where, bool leading);
+    virtual QString clauseHaving(HavingClause *having, bool leading) const;
+    virtual QString clauseHavingBetween(HavingClause *having, bool leading) const;
     virtual QString clauseGroup(GroupClause *group) const;
     virtual QString clauseJoin(JoinClause *join) const;
-    virtual QString clauseOrder(OrderClause *order) const;
+    virtual QString clauseOrder(OrderClause *order, bool leading) const;
     virtual QString clauseUnion(UnionClause *uc) const;
     virtual QString clauseLimit(LimitClause *limit) const;
     virtual QString clauseOffset(OffsetClause *offset) const;
@@ -76,6 +109,10 @@ protected:
 
 protected:
     void removeClause(QueryBuilder *builder, Clause::ClauseType type);
+
+    // a "?" while compiling a prepared statement, the literal value otherwise
+    QString bindParameter(const QVariant &value) const;
+    QString bindParameters(const QVariantList &values) const;
 };
 
 #endif // QUERYGRAMMAR_H
@@ -4,6 +4,9 @@
 #include "Grammar_p.h"
 #include "QueryGrammar.h"
 
+#include <QCache>
+#include <QMutex>
+
 class QueryGrammarPrivate : public GrammarPrivate
 {
     Q_DECLARE_PUBLIC(QueryGrammar)
@@ -18,6 +21,28 @@ public:
     // remove first "and" or "or"
     QString removeLeadingBoolean(const QString clause) const;
     QString dateWhere(const QString &type, WhereClause *where) const;
+
+    // structural key of the clauses, the values are collected in compile order
+    void fingerprint(QueryBuilder *builder, QString &key, Bindings &values, bool wheresOnly = false) const;
+    void fingerprint(int type, Clause *clause, QString &key, Bindings &values) const;
+    bool isPreparing() const;
+
+    // the builder being compiled, a clause may be shared by several builders
+    QueryBuilder *builderOf(Clause *clause) const
+    {
+        return compiling ? compiling : clause->query();
+    }
+
+    mutable QMutex cacheMutex;
+    QCache<QString, QString> cache;
+    bool cacheEnabled = true;
+    qint64 cacheHits = 0;
+    qint64 cacheMisses = 0;
+
+    QMutex prepareMutex;
+    QThread *preparingThread = nullptr;
+    mutable Bindings prepared;
+    mutable QueryBuilder *compiling = nullptr;
 };
 
 #endif // QUERYGRAMMAR_P_H
@@ -0,0 +1,310 @@
+#include "ResultSet.h"
+#include "QueryProfiler.h"
+#include "models/Model.h"
+
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QSqlField>
+#include <QHash>
+
+#include <cmath>
+
+struct ResultColumn
+{
+    QString name;
+    ResultSet::ColumnType type = ResultSet::Variant;
+    QVector<qint64> integers;
+    QVector<double> reals;
+    QVector<QString> texts;
+    QVector<QByteArray> blobs;
+    QVector<QVariant> variants;
+    QVector<bool> nulls;
+
+    static ResultSet::ColumnType typeOf(int type)
+    {
+        switch(type)
+        {
+        case QMetaType::Bool:
+        case QMetaType::Int:
+        case QMetaType::UInt:
+        case QMetaType::LongLong:
+        case QMetaType::ULongLong:
+            return ResultSet::Integer;
+        case QMetaType::Double:
+        case QMetaType::Float:
+            return ResultSet::Real;
+        case QMetaType::QString:
+            return ResultSet::Text;
+        case QMetaType::QByteArray:
+            return ResultSet::Blob;
+        default:
+            return ResultSet::Variant;
+        }
+    }
+
+    void reserve(int rows)
+    {
+        nulls.reserve(rows);
+        switch(type)
+        {
+        case ResultSet::Integer: integers.reserve(rows); break;
+        case ResultSet::Real: reals.reserve(rows); break;
+        case ResultSet::Text: texts.reserve(rows); break;
+        case ResultSet::Blob: blobs.reserve(rows); break;
+        case ResultSet::Variant: variants.reserve(rows); break;
+        }
+    }
+
+    // the declared type does not hold every value with sqlite, keep QVariants then
+    void degrade()
+    {
+        QVector<QVariant> values;
+        values.reserve(nulls.size());
+        for(int row = 0; row < nulls.size(); ++row)
+            values.append(value(row));
+
+        integers.clear();
+        reals.clear();
+        texts.clear();
+        blobs.clear();
+        variants = values;
+        type = ResultSet::Variant;
+    }
+
+    // whether the column keeps value of another type without losing anything
+    bool holds(const QVariant &value) const
+    {
+        const ResultSet::ColumnType valueType = typeOf(value.userType());
+        if(type == ResultSet::Integer && valueType == ResultSet::Real)
+        {
+            const double real = value.toDouble();
+            return std::isfinite(real) && std::trunc(real) == real
+                    && real >= -9223372036854775808.0 && real < 9223372036854775808.0;
+        }
+        if(type == ResultSet::Real && valueType == ResultSet::Integer)
+        {
+            // doubles hold integers up to 2^53 exactly
+            const qint64 integer = value.toLongLong();
+            return integer >= -(Q_INT64_C(1) << 53) && integer <= (Q_INT64_C(1) << 53)
+                    && value.userType() != QMetaType::ULongLong;
+        }
+
+        return false;
+    }
+
+    void append(const QVariant &value)
+    {
+        const bool null = value.isNull();
+        if(!null && type != ResultSet::Variant && typeOf(value.userType()) != type && !holds(value))
+            degrade();
+
+        nulls.append(null);
+        switch(type)
+        {
+        case ResultSet::Integer: integers.append(value.toLongLong()); break;
+        case ResultSet::Real: reals.append(value.toDouble()); break;
+        case ResultSet::Text: texts.append(value.toString()); break;
+        case ResultSet::Blob: blobs.append(value.toByteArray()); break;
+        case ResultSet::Variant: variants.append(value); break;
+        }
+    }
+
+    QVariant value(int row) const
+    {
+        if(nulls.at(row))
+            return QVariant();
+
+        switch(type)
+        {
+        case ResultSet::Integer: return integers.at(row);
+        case ResultSet::Real: return reals.at(row);
+        case ResultSet::Text: return texts.at(row);
+        case ResultSet::Blob: return blobs.at(row);
+        case ResultSet::Variant: break;
+        }
+
+        return variants.at(row);
+    }
+};
+
+class ResultSetData : public QSharedData
+{
+public:
+    QVector<ResultColumn> columns;
+    QHash<QString, int> indexes;
+    int rows = 0;
+};
+
+ResultSet::ResultSet()
+    : d(new ResultSetData)
+{
+
+}
+
+ResultSet::ResultSet(const ResultSet &other)
+    : d(other.d)
+{
+
+}
+
+ResultSet &ResultSet::operator=(const ResultSet &other)
+{
+    d = other.d;
+    return *this;
+}
+
+ResultSet::~ResultSet()
+{
+
+}
+
+ResultSet ResultSet::fromQuery(QSqlQuery &query)
+{
+    ResultSet set;
+    if(!query.isActive() || !query.isSelect())
+        return set;
+
+    ResultSetData *data = set.d.data();
+    QSqlRecord record = query.record();
+    data->columns.resize(record.count());
+    for(int i = 0; i < record.count(); ++i)
+    {
+        ResultColumn &column = data->columns[i];
+        column.name = record.fieldName(i);
+        column.type = ResultColumn::typeOf(record.field(i).type());
+        data->indexes.insert(column.name, i);
+    }
+
+    int size = query.size();
+    if(size > 0)
+    {
+        for(auto &column : data->columns)
+            column.reserve(size);
+    }
+
+    const int count = data->columns.size();
+    while(query.next())
+    {
+        for(int i = 0; i < count; ++i)
+            data->columns[i].append(query.value(i));
+        ++data->rows;
+    }
+    QueryProfiler::instance()->consumed(query, data->rows);
+
+    return set;
+}
+
+int ResultSet::rowCount() const
+{
+    return d->rows;
+}
+
+int ResultSet::columnCount() const
+{
+    return d->columns.size();
+}
+
+QString ResultSet::fieldName(int column) const
+{
+    return d->columns.at(column).name;
+}
+
+int ResultSet::indexOf(const QString &field) const
+{
+    return d->indexes.value(field, -1);
+}
+
+ResultSet::ColumnType ResultSet::columnType(int column) const
+{
+    return d->columns.at(column).type;
+}
+
+bool ResultSet::isNull(int row, int column) const
+{
+    return d->columns.at(column).nulls.at(row);
+}
+
+QVariant ResultSet::value(int row, int column) const
+{
+    return d->columns.at(column).value(row);
+}
+
+QVariantList ResultSet::column(int column) const
+{
+    const ResultColumn &values = d->columns.at(column);
+    QVariantList list;
+    list.reserve(d->rows);
+    for(int row = 0; row < d->rows; ++row)
+        list.append(values.value(row));
+
+    return list;
+}
+
+Collection ResultSet::toModels(const Model *prototype) const
+{
+    Collection models;
+    if(!prototype)
+        return models;
+
+    models.reserve(d->rows);
+    for(const Row &row : *this)
+    {
+        Model *model = prototype->newInstance(row.toMap());
+        if(model)
+            models << model;
+    }
+
+    return models;
+}
+
+bool ResultSet::Row::isNull(int column) const
+{
+    return m_set->isNull(m_row, column);
+}
+
+QVariant ResultSet::Row::value(int column) const
+{
+    return m_set->value(m_row, column);
+}
+
+QVariant ResultSet::Row::value(const QString &column) const
+{
+    int index = m_set->indexOf(column);
+    return index < 0 ? QVariant() : m_set->value(m_row, index);
+}
+
+qint64 ResultSet::Row::toLongLong(int column) const
+{
+    const ResultColumn &values = m_set->d->columns.at(column);
+    if(values.type == Integer)
+        return values.nulls.at(m_row) ? 0 : values.integers.at(m_row);
+
+    return values.value(m_row).toLongLong();
+}
+
+double ResultSet::Row::toDouble(int column) const
+{
+    const ResultColumn &values = m_set->d->columns.at(column);
+    if(values.type == Real)
+        return values.nulls.at(m_row) ? 0.0 : values.reals.at(m_row);
+
+    return values.value(m_row).toDouble();
+}
+
+QString ResultSet::Row::toString(int column) const
+{
+    const ResultColumn &values = m_set->d->columns.at(column);
+    if(values.type == Text)
+        return values.nulls.at(m_row) ? QString() : values.texts.at(m_row);
+
+    return values.value(m_row).toString();
+}
+
+QVariantMap ResultSet::Row::toMap() const
+{
+    QVariantMap map;
+    for(int column = 0; column < m_set->columnCount(); ++column)
+        map.insert(m_set->fieldName(column), m_set->value(m_row, column));
+
+    return map;
+}
@@ -0,0 +1,99 @@
+#ifndef RESULTSET_H
+#define RESULTSET_H
+
+#include "models/Collection.h"
+
+#include <QSharedDataPointer>
+#include <QVariant>
+#include <QVector>
+
+class Model;
+class QSqlQuery;
+
+/**
+ * @brief The ResultSet class
+ * the rows of a query stored by column, every column is one vector of its
+ * type (integer, real, text, blob) with a null mask, a column of mixed types
+ * falls back to QVariant. No object is allocated per row.
+ *
+ * implicitly shared, a Row is a view that stays valid while the set lives.
+ */
+class ResultSetData;
+class ResultSet
+{
+public:
+    enum ColumnType
+    {
+        Integer,
+        Real,
+        Text,
+        Blob,
+        Variant
+    };
+
+    class Row
+    {
+    public:
+        Row(const ResultSet *set, int row) : m_set(set), m_row(row) { }
+
+        int index() const { return m_row; }
+        bool isNull(int column) const;
+        QVariant value(int column) const;
+        QVariant value(const QString &column) const;
+        qint64 toLongLong(int column) const;
+        double toDouble(int column) const;
+        QString toString(int column) const;
+        QVariantMap toMap() const;
+
+    private:
+        const ResultSet *m_set = nullptr;
+        int m_row = 0;
+    };
+
+    class const_iterator
+    {
+    public:
+        const_iterator(const ResultSet *set, int row) : m_set(set), m_row(row) { }
+        Row operator*() const { return Row(m_set, m_row); }
+        const_iterator &operator++() { ++m_row; return *this; }
+        bool operator!=(const const_iterator &other) const { return m_row != other.m_row; }
+        bool operator==(const const_iterator &other) const { return m_row == other.m_row; }
+
+    private:
+        const ResultSet *m_set = nullptr;
+        int m_row = 0;
+    };
+
+    ResultSet();
+    ResultSet(const ResultSet &other);
+    ResultSet &operator=(const ResultSet &other);
+    ~ResultSet();
+
+    // read the remaining rows of an executed query
+    static ResultSet fromQuery(QSqlQuery &query);
+
+    bool isEmpty() const { return rowCount() == 0; }
+    int rowCount() const;
+    int columnCount() const;
+    QString fieldName(int column) const;
+    int indexOf(const QString &field) const;
+    ColumnType columnType(int column) const;
+
+    Row row(int row) const { return Row(this, row); }
+    Row operator[](int row) const { return Row(this, row); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, rowCount()); }
+
+    bool isNull(int row, int column) const;
+    QVariant value(int row, int column) const;
+    // the whole column as QVariants
+    QVariantList column(int column) const;
+
+    // opt-in: a new model of the class of prototype per row, owned by the caller
+    Collection toModels(const Model *prototype) const;
+
+private:
+    QSharedDataPointer<ResultSetData> d;
+};
+
+#endif // RESULTSET_H
@@ -29,3 +29,22 @@ QString SQLiteQueryGrammar::compileUpdate(QueryBuilder *builder, const QList< QV
     return QString("update %1 set %2 where %3 in (%4)")
             .arg(table).arg(columns.join(", ")).arg(wrap("rowid")).arg(select);
 }
+
+QString SQLiteQueryGrammar::compileUpsert(QueryBuilder *builder, const Records &values,
+                                          const QStringList &uniqueBy, const QStringList &update)
+{
+    if(values.isEmpty() || uniqueBy.isEmpty())
+        return QString();
+
+    QString sql = this->compileInsert(builder, values)
+            + QString(" on conflict (%1) do ").arg(this->columnize(uniqueBy));
+
+    if(update.isEmpty())
+        return sql + "nothing";
+
+    QStringList columns;
+    foreach (auto &column, update)
+        columns << wrap(column) + " = excluded." + wrap(column);
+
+    return sql + "update set " + columns.join(", ");
+}
@@ -9,6 +9,9 @@ public:
     explicit SQLiteQueryGrammar(QObject *parent = nullptr);
 
     QString compileUpdate(QueryBuilder *builder, const QList<QVariantMap> &values) override;
+    // insert ... on conflict (...) do update set column = excluded.column, needs SQLite 3.24
+    QString compileUpsert(QueryBuilder *builder, const Records &values,
+                          const QStringList &uniqueBy, const QStringList &update) override;
 };
 
 #endif // SQLITEQUERYGRAMMAR_H
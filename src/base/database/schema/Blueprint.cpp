@@ -74,7 +74,12 @@ public:
      */
     QString createIndexName(const QString &type, const QStringList &columns) const
     {
-        QString index = table + "_" + columns.join("_") + "_" + type;
+        // a column may carry its order or collation, "title collate nocase desc"
+        QStringList names;
+        foreach (auto &column, columns)
+            names << column.section(QRegExp("\\s+"), 0, 0, QString::SectionSkipEmpty);
+
+        QString index = table + "_" + names.join("_") + "_" + type;
         index = index.toLower();
         return index.replace(QRegExp("-|\\."), "_");
     }
@@ -91,9 +96,7 @@ public:
         case Command::Foreign:      indexType = "foreign";        break;
         default: indexType = "index";
         }
-        QString index = table + "_" + columns.join("_") + "_" + indexType;
-        index = index.toLower();
-        return index.replace(QRegExp("-|\\."), "_");
+        return createIndexName(indexType, columns);
     }
 
     ColumnDefinition &addColumn(const QString &type, const QString &name, const QHash<int, QVariant> &parameters = {})
@@ -284,6 +287,7 @@ public:
     Grammar *grammar = nullptr;
     QString table;
     bool temporary = false;
+    bool withoutRowId = false;
 
     QList<Command> commands;
     QList<ColumnDefinition> columns;
@@ -365,6 +369,13 @@ QStringList Blueprint::toSql()
     return d->grammar->compile(this);
 }
 
+QStringList Blueprint::toSql(const Grammar *grammar)
+{
+    Q_D(Blueprint);
+    d->grammar = const_cast<Grammar *>(grammar);
+    return this->toSql();
+}
+
 QString Blueprint::table() const
 {
     Q_D(const Blueprint);
@@ -401,6 +412,18 @@ void Blueprint::temporary()
     d->temporary = true;
 }
 
+bool Blueprint::isWithoutRowId() const
+{
+    Q_D(const Blueprint);
+    return d->withoutRowId;
+}
+
+void Blueprint::withoutRowId()
+{
+    Q_D(Blueprint);
+    d->withoutRowId = true;
+}
+
 void Blueprint::drop()
 {
     Q_D(Blueprint);
@@ -513,6 +536,23 @@ Command &Blueprint::index(const QStringList &columns, const QString &name)
     return d->indexCommand(Command::Index, columns, name);
 }
 
+Command &Blueprint::rawIndex(const QString &expression, const QString &name)
+{
+    Q_D(Blueprint);
+    QString indexName = name;
+    if(indexName.isEmpty())
+    {
+        // named after the expression, "lower(title)" gives <table>_lower_title_index
+        QString words = expression.toLower().replace(QRegExp("\\W+"), "_");
+        words.remove(QRegExp("^_+|_+$"));
+        indexName = d->createIndexName("index", {words});
+    }
+
+    Command &command = d->indexCommand(Command::Index, {}, indexName);
+    command["expression"] = expression;
+    return command;
+}
+
 Command &Blueprint::spatialIndex(const QStringList &columns, const QString &name)
 {
     Q_D(Blueprint);
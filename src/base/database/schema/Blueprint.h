@@ -51,6 +51,7 @@ public:
     virtual ~Blueprint();
 
     bool isTemporary() const;
+    bool isWithoutRowId() const;
     QList<Command> allCommands() const;
     QList<Command> commands(Command::Type type) const;
     Command command(Command::Type type) const;
@@ -59,6 +60,8 @@ public:
 
     void build(const Connection *connection, const  Grammar *grammar);
     QStringList toSql();
+    // compile with grammar, without a connection to run it on
+    QStringList toSql(const Grammar *grammar);
 
     QString table() const;
 
@@ -68,6 +71,9 @@ public:
     void create();
     // Indicate that the table needs to be temporary.
     void temporary();
+    // Store the table in its primary key instead of a rowid b-tree (SQLite),
+    // the table needs a primary key which is not autoincrement.
+    void withoutRowId();
 
     // Indicate that the table should be dropped.
     void drop();
@@ -108,8 +114,10 @@ public:
     Command &primary(const QStringList &columns, const QString &name = "");
     // Specify a unique index for the table.
     Command &unique(const QStringList &columns, const QString &name = "");
-    // Specify an index for the table.
+    // Specify an index for the table, a column may carry its order, "title desc".
     Command &index(const QStringList &columns, const QString &name = "");
+    // Specify an index on a raw SQL expression, e.g. "lower(title)", named after it by default.
+    Command &rawIndex(const QString &expression, const QString &name = "");
     // Specify a spatial index for the table.
     Command &spatialIndex(const QStringList &columns, const QString &name = "");
     /**
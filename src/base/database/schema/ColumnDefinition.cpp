@@ -156,6 +156,18 @@ ColumnDefinition &ColumnDefinition::useCurrent()
     return *this;
 }
 
+ColumnDefinition &ColumnDefinition::virtualAs(const QString &expression)
+{
+    d->attributes[VirtualAs] = expression;
+    return *this;
+}
+
+ColumnDefinition &ColumnDefinition::storedAs(const QString &expression)
+{
+    d->attributes[StoredAs] = expression;
+    return *this;
+}
+
 int ColumnDefinition::length() const
 {
     return d->attributes[Length].toInt();
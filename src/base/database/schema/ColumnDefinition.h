@@ -20,11 +20,11 @@
  * - nullable       // Allow NULL values to be inserted into the column
  * - primary        // Add a primary index
  * - spatialIndex   // Add a spatial index
- * - storedAs       // Create a stored generated column (MySQL)
+ * - storedAs       // Create a stored generated column (MySQL/SQLite)
  * - unique         // Add a unique index
  * - unsigned       // Set the INTEGER column as UNSIGNED (MySQL)
  * - useCurrent     // Set the TIMESTAMP column to use CURRENT_TIMESTAMP as default value
- * - virtaulAs      // Create a virtual generated column (MySQL)
+ * - virtualAs      // Create a virtual generated column (MySQL/SQLite)
  * - persisted      // Mark the computed generated column as persistent (SQL Server)
  *
  */
@@ -58,6 +58,8 @@ public:
         SpatialIndex,
         Total,
         Type,   // the column type
+        VirtualAs,
+        StoredAs,
 
         UserKey = 0x0100
     };
@@ -121,6 +123,12 @@ public:
     // Set the TIMESTAMP column to use CURRENT_TIMESTAMP as default value
     ColumnDefinition &useCurrent();
 
+    // Create a virtual generated column computed from the expression
+    ColumnDefinition &virtualAs(const QString &expression);
+
+    // Create a stored generated column computed from the expression
+    ColumnDefinition &storedAs(const QString &expression);
+
 protected:
     int length() const;
     int total() const;
@@ -27,7 +27,8 @@ CommandPrivate::CommandPrivate(Blueprint *blueprint, Command::Type command,
 }
 
 CommandPrivate::CommandPrivate(const CommandPrivate &other)
-    : ref(1), type(other.type), columns(other.columns), index(other.index)
+    : blueprint(other.blueprint), ref(1), type(other.type), columns(other.columns),
+      index(other.index), attributes(other.attributes)
 {
 
 }
@@ -135,6 +136,20 @@ Command &Command::initiallyImmediate(bool value)
     return *this;
 }
 
+Command &Command::where(const QString &condition)
+{
+    qAtomicDetach(d);
+    d->attributes["where"] = condition;
+    return *this;
+}
+
+Command &Command::include(const QStringList &columns)
+{
+    qAtomicDetach(d);
+    d->attributes["include"] = columns;
+    return *this;
+}
+
 Blueprint *Command::blueprint() const
 {
     return d->blueprint;
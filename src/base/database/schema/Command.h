@@ -15,6 +15,10 @@
  * - deferrable         // set the foreign key as deferrable (for PastgreSQL)
  * - initiallyImmediate // set the default time to check the canstraint (PastgreSQL)
  *
+ * index commands
+ * - where          // make a partial index of the rows matching a condition
+ * - include        // append covering columns to the index
+ *
  */
 class Blueprint;
 class CommandPrivate;
@@ -80,6 +84,12 @@ public:
     // Set the default time to check the constraint (PostgreSQL)
     Command &initiallyImmediate(bool value = true);
 
+    // Index only the rows matching the raw condition, e.g. "available = 1"
+    Command &where(const QString &condition);
+
+    // Append columns only read by queries, so the index covers them
+    Command &include(const QStringList &columns);
+
     Blueprint *blueprint() const;
     QVariantHash &attributes() const;
     Command::Type type() const;
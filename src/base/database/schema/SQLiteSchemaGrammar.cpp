@@ -43,6 +43,36 @@ public:
         return QString(", primary key (%1)").arg(q->columnize(primary.columns()));
     }
 
+    /**
+     * the indexed part of "create index ... on table (...)": the raw expression
+     * of a rawIndex(), or the columns, each keeping its collation and order,
+     * followed by the covering columns. SQLite has no "include" clause, the
+     * trailing columns make the index cover the queries all the same.
+     */
+    QString indexColumns(const Command &command)
+    {
+        Q_Q(SQLiteSchemaGrammar);
+        QString expression = command["expression"].toString();
+        if(!expression.isEmpty())
+            return expression;
+
+        QStringList columns;
+        foreach (auto &column, command.columns() + command["include"].toStringList())
+        {
+            QString name = column.section(QRegExp("\\s+"), 0, 0, QString::SectionSkipEmpty);
+            QString suffix = column.trimmed().mid(name.size());
+            columns << q->wrap(name) + suffix;
+        }
+
+        return columns.join(", ");
+    }
+
+    QString indexWhere(const Command &command)
+    {
+        QString condition = command["where"].toString();
+        return condition.isEmpty() ? QString() : " where " + condition;
+    }
+
 private:
     QString generateForeignKey(const Command &foreign)
     {
@@ -232,8 +262,10 @@ QString SQLiteSchemaGrammar::compileCreate(const Command &command)
     QString foreignKeys = d->getForeignKeys(blueprint);
     QString primaryKey = d->getPrimaryKey(blueprint);
 
-    return QString("%1 table %2 (%3%4%5)")
-            .arg(create).arg(table).arg(columns).arg(foreignKeys).arg(primaryKey);
+    QString options = blueprint->isWithoutRowId() ? " without rowid" : "";
+
+    return QString("%1 table %2 (%3%4%5)%6")
+            .arg(create).arg(table).arg(columns).arg(foreignKeys).arg(primaryKey).arg(options);
 }
 
 QString SQLiteSchemaGrammar::compileAdd(const Command &command)
@@ -296,18 +328,22 @@ QString SQLiteSchemaGrammar::compilePrimary(const Command &command)
 
 QString SQLiteSchemaGrammar::compileUnique(const Command &command)
 {
-    return QString("create unique index %1 on %2 (%3)")
+    Q_D(SQLiteSchemaGrammar);
+    return QString("create unique index %1 on %2 (%3)%4")
             .arg(wrap(command.indexName()))
             .arg(wrapTable(command.blueprint()->table()))
-            .arg(columnize(command.columns()));
+            .arg(d->indexColumns(command))
+            .arg(d->indexWhere(command));
 }
 
 QString SQLiteSchemaGrammar::compileIndex(const Command &command)
 {
-    return QString("create index %1 on %2 (%3)")
+    Q_D(SQLiteSchemaGrammar);
+    return QString("create index %1 on %2 (%3)%4")
             .arg(wrap(command.indexName()))
             .arg(wrapTable(command.blueprint()->table()))
-            .arg(columnize(command.columns()));
+            .arg(d->indexColumns(command))
+            .arg(d->indexWhere(command));
 }
 
 QString SQLiteSchemaGrammar::compileSpatialIndex(const Command &command)
@@ -398,6 +434,14 @@ QString SQLiteSchemaGrammar::applyModifiers(const ColumnDefinition &column) cons
     QVariant value = column.value(ColumnDefinition::DefaultValue);
     modifiers << (value.toBool() ? " default " + quoteString(value.toString()) : "");
 
+    // generated column modifier, a stored one can not be added to an existing table
+    QString virtualAs = column.value(ColumnDefinition::VirtualAs).toString();
+    QString storedAs = column.value(ColumnDefinition::StoredAs).toString();
+    if(!virtualAs.isEmpty())
+        modifiers << " generated always as (" + virtualAs + ") virtual";
+    else if(!storedAs.isEmpty())
+        modifiers << " generated always as (" + storedAs + ") stored";
+
 
     // auto increment modifier
     modifiers << (column.value(ColumnDefinition::AutoIncrement).toBool() ? " primary key autoincrement" : "");
@@ -7,6 +7,9 @@
 
 Q_LOGGING_CATEGORY(lcVLCMetadataControl, "mcplayer.VLCMetadataControl")
 
+// broken or network files can stall the parser with the libvlc default timeout
+static const int DefaultParseTimeout = 5000;
+
 
 typedef QMap<libvlc_meta_t, QString> VLCMetaDataKeyLookup;
 Q_GLOBAL_STATIC(VLCMetaDataKeyLookup, metadataKeys)
@@ -122,6 +125,7 @@ public:
     QVariantMap metadata;
     libvlc_media_t *vlcMedia = nullptr;
     libvlc_event_manager_t *vlcEvent = nullptr;
+    int parseTimeout = DefaultParseTimeout;
 };
 
 QString VLCMetadataControlPrivate::meta(libvlc_media_t *mdeia, libvlc_meta_t meta_id)
@@ -185,6 +189,10 @@ void VLCMetadataControlPrivate::processEvents(const libvlc_event_t *event, void
     {
     case libvlc_MediaParsedChanged:
         qDebug(lcVLCMetadataControl) << "libvlc_MediaParsedChanged";
+        if(event->u.media_parsed_changed.new_status == libvlc_media_parsed_status_timeout)
+            qWarning(lcVLCMetadataControl) << "parse media timeout after" << d->parseTimeout << "ms";
+        else if(event->u.media_parsed_changed.new_status == libvlc_media_parsed_status_failed)
+            qWarning(lcVLCMetadataControl) << "parse media failed";
         d->updateMetaData();
         emit d->q_func()->metadataChanged();
         break;
@@ -293,5 +301,18 @@ void VLCMetadataControl::parseMediaAsync(libvlc_media_t *media, int type)
     d->attachMediaEvents(d->vlcMedia);
 
     libvlc_media_parse_flag_t flag = libvlc_media_parse_flag_t(type);
-    libvlc_media_parse_with_options(d->vlcMedia, flag, -1); // -1 used default timeout
+    libvlc_media_parse_with_options(d->vlcMedia, flag, d->parseTimeout);
+}
+
+int VLCMetadataControl::parseTimeout() const
+{
+    Q_D(const VLCMetadataControl);
+    return d->parseTimeout;
+}
+
+void VLCMetadataControl::setParseTimeout(int msec)
+{
+    Q_D(VLCMetadataControl);
+    // libvlc reads 0 as no limit at all, a parse must always end
+    d->parseTimeout = msec > 0 ? msec : DefaultParseTimeout;
 }
@@ -28,6 +28,10 @@ public:
 
     void parseMediaAsync(libvlc_media_t *media, int type);
 
+    // milliseconds libvlc may spend parsing a media, msec <= 0 restores the default of 5 s
+    int parseTimeout() const;
+    void setParseTimeout(int msec);
+
 signals:
 
 public slots: